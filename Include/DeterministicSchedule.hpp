@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Threading {
+	// One dequeued task, sequence is its submission number since recording started
+	struct ScheduleEntry {
+		std::uint64_t sequence;
+		// Informational, replay enforces the order but not the worker
+		std::size_t worker;
+	};
+
+	struct Schedule {
+		// Zero takes tasks in queue order, any other value picks among the queued tasks pseudo-randomly
+		std::uint64_t seed = 0;
+		std::vector<ScheduleEntry> entries;
+		// Set when a replay waited too long for a recorded task and fell back to seeded order
+		bool diverged = false;
+	};
+
+	// Plain text, a "seed" line followed by one "sequence worker" line per task
+	inline bool SaveSchedule(const std::string& path, const Schedule& schedule) {
+		std::ofstream file(path);
+		if (!file) {
+			return false;
+		}
+		file << "seed " << schedule.seed << '\n';
+		for (const ScheduleEntry& entry : schedule.entries) {
+			file << entry.sequence << ' ' << entry.worker << '\n';
+		}
+		return (bool)file;
+	}
+
+	inline bool LoadSchedule(const std::string& path, Schedule& schedule) {
+		std::ifstream file(path);
+		std::string header;
+		Schedule loaded;
+		if (!(file >> header >> loaded.seed) || header != "seed") {
+			return false;
+		}
+		ScheduleEntry entry;
+		while (file >> entry.sequence >> entry.worker) {
+			loaded.entries.push_back(entry);
+		}
+		if (!file.eof()) {
+			return false;
+		}
+		schedule = std::move(loaded);
+		return true;
+	}
+
+	// Small seeded generator (splitmix64) so schedules do not depend on the standard library's engines
+	inline std::uint64_t NextScheduleRandom(std::uint64_t& state) {
+		std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+}
\ No newline at end of file
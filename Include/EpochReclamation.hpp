@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "ThreadSanitizer.hpp"
+
+namespace Threading {
+	// Participants publish retirements when they collect, so counts lag by up to one collect threshold each
+	struct EpochMetrics {
+		std::uint64_t epoch;
+		std::uint64_t retired;
+		std::uint64_t reclaimed;
+		// Retired but not yet freed, the peak is sampled at every collect
+		std::uint64_t unreclaimed;
+		std::uint64_t peakUnreclaimed;
+		std::size_t participants;
+	};
+
+	// Epoch-based reclamation for lock-free structures
+	// Readers touch shared nodes only inside a Guard, writers Retire nodes after unlinking them
+	// A node retired at epoch e is freed once the global epoch reaches e + 2, by then every reader that could see it has left
+	class EpochDomain {
+	public:
+		using lock_type = std::unique_lock<std::mutex>;
+		using deleter_type = void(*)(void*);
+
+		static constexpr std::uint64_t Inactive = ~0ull;
+		// Retired nodes a participant buffers before it tries to advance the epoch and free them
+		static constexpr std::size_t DefaultCollectThreshold = 64;
+	protected:
+		struct alignas(64) Record {
+			std::atomic_uint64_t epoch;
+			std::atomic_bool used;
+			Record* next;
+
+			Record() : epoch(Inactive), used(true), next(nullptr) {
+
+			}
+		};
+
+		struct Retired {
+			void* pointer;
+			deleter_type deleter;
+			std::uint64_t epoch;
+		};
+
+		alignas(64) std::atomic_uint64_t _epoch;
+		// Records are never unlinked, a departing participant marks its record unused for the next one
+		std::atomic<Record*> _records;
+		std::atomic_size_t _participants;
+		std::atomic_uint64_t _retired;
+		std::atomic_uint64_t _reclaimed;
+		std::atomic_uint64_t _peakUnreclaimed;
+		// Nodes left behind by participants that were destroyed before they could be freed
+		std::mutex _orphanMutex;
+		std::vector<Retired> _orphans;
+		std::atomic_size_t _orphanCount;
+	public:
+		// One per thread using the domain, not thread safe itself and may only be used by one thread at a time
+		class Participant {
+		protected:
+			EpochDomain& _domain;
+			Record* _record;
+			std::size_t _depth;
+			std::size_t _threshold;
+			// Retired since the last Collect published the counters
+			std::size_t _unpublished;
+			std::vector<Retired> _retired;
+		public:
+			Participant(EpochDomain& domain, std::size_t collectThreshold = DefaultCollectThreshold) : _domain(domain), _record(domain.Acquire()), _depth(0), _threshold(collectThreshold ? collectThreshold : 1), _unpublished(0) {
+
+			}
+
+			Participant(const Participant&) = delete;
+			Participant& operator=(const Participant&) = delete;
+
+			~Participant() {
+				Collect();
+				_domain.Release(_record, _retired);
+			}
+
+			// Nested calls only announce once
+			void Enter() {
+				if (_depth++ == 0) {
+					// The announcement must be visible before any shared node is read
+#if THREADPOOL_TSAN
+					// ThreadSanitizer does not model fences, a sequentially consistent exchange orders the announcement by itself
+					_record->epoch.exchange(_domain._epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+#else
+					_record->epoch.store(_domain._epoch.load(std::memory_order_acquire), std::memory_order_release);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+				}
+			}
+
+			void Leave() {
+				if (--_depth == 0) {
+					_record->epoch.store(Inactive, std::memory_order_release);
+				}
+			}
+
+			// Pointer must already be unreachable for readers that enter from now on
+			template <class _ValueTy>
+			void Retire(_ValueTy* pointer) {
+				Retire(pointer, [](void* p) { delete static_cast<_ValueTy*>(p); });
+			}
+
+			void Retire(void* pointer, deleter_type deleter) {
+				_retired.push_back(Retired{ pointer, deleter, _domain._epoch.load(std::memory_order_acquire) });
+				++_unpublished;
+				if (_retired.size() >= _threshold) {
+					Collect();
+				}
+			}
+
+			// Tries to advance the epoch then frees every node that is old enough, returns how many were freed
+			std::size_t Collect() {
+				_domain.Publish(_unpublished);
+				_unpublished = 0;
+				_domain.TryAdvance();
+				std::uint64_t epoch = _domain._epoch.load(std::memory_order_acquire);
+				std::size_t freed = Free(_retired, epoch);
+				if (_domain._orphanCount.load(std::memory_order_relaxed) != 0) {
+					lock_type lock(_domain._orphanMutex);
+					freed += Free(_domain._orphans, epoch);
+					_domain._orphanCount.store(_domain._orphans.size(), std::memory_order_relaxed);
+				}
+				_domain._reclaimed.fetch_add(freed, std::memory_order_relaxed);
+				return freed;
+			}
+
+			std::size_t Pending() const {
+				return _retired.size();
+			}
+		private:
+			static std::size_t Free(std::vector<Retired>& retired, std::uint64_t epoch) {
+				std::size_t kept = 0;
+				for (Retired& node : retired) {
+					if (node.epoch + 2 <= epoch) {
+						node.deleter(node.pointer);
+					} else {
+						retired[kept++] = node;
+					}
+				}
+				std::size_t freed = retired.size() - kept;
+				retired.resize(kept);
+				return freed;
+			}
+		};
+
+		// RAII critical section, nodes read inside stay allocated until it ends
+		class Guard {
+		protected:
+			Participant& _participant;
+		public:
+			Guard(Participant& participant) : _participant(participant) {
+				_participant.Enter();
+			}
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+
+			~Guard() {
+				_participant.Leave();
+			}
+		};
+
+		EpochDomain() : _epoch(0), _records(nullptr), _participants(0), _retired(0), _reclaimed(0), _peakUnreclaimed(0), _orphanCount(0) {
+
+		}
+
+		EpochDomain(const EpochDomain&) = delete;
+		EpochDomain& operator=(const EpochDomain&) = delete;
+
+		// Every participant must have been destroyed, nothing can still be reading
+		~EpochDomain() {
+			for (Retired& node : _orphans) {
+				node.deleter(node.pointer);
+			}
+			Record* record = _records.load(std::memory_order_acquire);
+			while (record != nullptr) {
+				Record* next = record->next;
+				delete record;
+				record = next;
+			}
+		}
+
+		EpochMetrics GetMetrics() const {
+			std::uint64_t retired = _retired.load(std::memory_order_relaxed);
+			std::uint64_t reclaimed = _reclaimed.load(std::memory_order_relaxed);
+			return EpochMetrics{ _epoch.load(std::memory_order_relaxed), retired, reclaimed, retired > reclaimed ? retired - reclaimed : 0, _peakUnreclaimed.load(std::memory_order_relaxed), _participants.load(std::memory_order_relaxed) };
+		}
+	private:
+		Record* Acquire() {
+			_participants.fetch_add(1, std::memory_order_relaxed);
+			for (Record* record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+				bool used = false;
+				if (!record->used.load(std::memory_order_relaxed) && record->used.compare_exchange_strong(used, true, std::memory_order_acquire)) {
+					return record;
+				}
+			}
+			Record* record = new Record();
+			Record* head = _records.load(std::memory_order_relaxed);
+			do {
+				record->next = head;
+			} while (!_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+			return record;
+		}
+
+		void Release(Record* record, std::vector<Retired>& retired) {
+			if (!retired.empty()) {
+				lock_type lock(_orphanMutex);
+				_orphans.insert(_orphans.end(), retired.begin(), retired.end());
+				_orphanCount.store(_orphans.size(), std::memory_order_relaxed);
+			}
+			record->epoch.store(Inactive, std::memory_order_release);
+			record->used.store(false, std::memory_order_release);
+			_participants.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		void Publish(std::size_t retired) {
+			std::uint64_t total = _retired.fetch_add(retired, std::memory_order_relaxed) + retired;
+			std::uint64_t reclaimed = _reclaimed.load(std::memory_order_relaxed);
+			std::uint64_t unreclaimed = total > reclaimed ? total - reclaimed : 0;
+			std::uint64_t peak = _peakUnreclaimed.load(std::memory_order_relaxed);
+			while (unreclaimed > peak && !_peakUnreclaimed.compare_exchange_weak(peak, unreclaimed, std::memory_order_relaxed)) {
+
+			}
+		}
+
+		// Moves the epoch forward if every participant inside a Guard has seen the current one
+		bool TryAdvance() {
+			std::uint64_t epoch = _epoch.load(std::memory_order_seq_cst);
+			for (Record* record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+				std::uint64_t announced = record->epoch.load(std::memory_order_seq_cst);
+				if (announced != Inactive && announced != epoch) {
+					return false;
+				}
+			}
+			return _epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+	};
+}
\ No newline at end of file
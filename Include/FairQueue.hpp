@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Threading {
+	using TenantId = std::size_t;
+
+	// Tenant zero always exists and receives work pushed without a tenant
+	constexpr TenantId DefaultTenant = 0;
+
+	struct TenantSettings {
+		std::string name;
+		// Tasks taken per round-robin turn relative to other tenants
+		std::size_t weight = 1;
+		// Most tasks running at once, zero is unlimited
+		std::size_t maxConcurrency = 0;
+		// Orders the tenant's tasks by their deadline member instead of FIFO, tasks without one sort first
+		bool earliestDeadlineFirst = false;
+	};
+
+	struct TenantMetrics {
+		TenantId id;
+		std::string name;
+		std::size_t weight;
+		std::size_t maxConcurrency;
+		std::uint64_t submitted;
+		std::uint64_t completed;
+		std::size_t queued;
+		std::size_t peakQueued;
+		std::size_t running;
+	};
+
+	// Deficit round-robin over per-tenant FIFO or earliest-deadline-first queues, every task costs one unit and a turn is worth weight units
+	// Items need a deadline member ordered with <
+	// Not thread safe, the owner serialises Push, Pop and capped Complete under its queue lock
+	// Empty, Runnable and uncapped Complete may be called without the lock
+	template <class _ItemTy, class _AllocTy = std::allocator<_ItemTy>>
+	class FairQueue {
+	protected:
+		struct Tenant;
+	public:
+		using item_type = _ItemTy;
+		// Backs every tenant's queue storage
+		using allocator_type = _AllocTy;
+		// Stable for the queue's lifetime, Pop hands one out so Complete needs no lookup while tenants are being added
+		using handle_type = Tenant*;
+	protected:
+		struct Tenant {
+			TenantId id;
+			TenantSettings settings;
+			std::deque<item_type, allocator_type> works;
+			std::size_t deficit;
+			bool scheduled;
+			std::uint64_t submitted;
+			std::size_t peakQueued;
+			std::atomic_uint64_t completed;
+			std::atomic_size_t running;
+
+			Tenant(TenantId i, TenantSettings s, const allocator_type& allocator) : id(i), settings(std::move(s)), works(allocator), deficit(0), scheduled(false), submitted(0), peakQueued(0), completed(0), running(0) {
+				settings.weight = settings.weight ? settings.weight : 1;
+			}
+		};
+
+		std::vector<std::unique_ptr<Tenant>> _tenants;
+		// Tenants with queued work in round-robin order, the front tenant is mid-turn while its deficit is non-zero
+		std::deque<TenantId> _scheduled;
+		std::atomic_size_t _size;
+		// Tenants with queued work that are below their concurrency cap
+		std::atomic_size_t _runnable;
+		allocator_type _allocator;
+	public:
+		FairQueue(const allocator_type& allocator = allocator_type()) : _size(0), _runnable(0), _allocator(allocator) {
+			TenantSettings settings;
+			settings.name = "default";
+			AddTenant(settings);
+		}
+
+		TenantId AddTenant(TenantSettings settings) {
+			_tenants.emplace_back(new Tenant(_tenants.size(), std::move(settings), _allocator));
+			return _tenants.size() - 1;
+		}
+
+		std::size_t Tenants() const {
+			return _tenants.size();
+		}
+
+		static bool Capped(handle_type tenant) {
+			return tenant->settings.maxConcurrency != 0;
+		}
+
+		bool Empty() const {
+			return _size.load(std::memory_order_acquire) == 0;
+		}
+
+		std::size_t Size() const {
+			return _size.load(std::memory_order_acquire);
+		}
+
+		bool Runnable() const {
+			return _runnable.load(std::memory_order_acquire) != 0;
+		}
+
+		void Push(TenantId id, item_type item) {
+			Tenant& tenant = *_tenants[id];
+			bool runnable = Runnable(tenant);
+			Insert(tenant, std::move(item));
+			++tenant.submitted;
+			tenant.peakQueued = tenant.works.size() > tenant.peakQueued ? tenant.works.size() : tenant.peakQueued;
+			if (!tenant.scheduled) {
+				tenant.scheduled = true;
+				_scheduled.push_back(id);
+			}
+			_size.fetch_add(1, std::memory_order_release);
+			UpdateRunnable(runnable, Runnable(tenant));
+		}
+
+		// Returns false when no tenant is runnable, the popped task counts as running until Complete
+		bool Pop(item_type& item, handle_type& handle) {
+			if (!Runnable()) {
+				return false;
+			}
+			for (;;) {
+				TenantId id = _scheduled.front();
+				Tenant& tenant = *_tenants[id];
+				if (!Runnable(tenant)) {
+					// At its cap, keep the deficit and let the others take their turns
+					_scheduled.pop_front();
+					_scheduled.push_back(id);
+					continue;
+				}
+				if (tenant.deficit == 0) {
+					tenant.deficit = tenant.settings.weight;
+				}
+				if (tenant.settings.earliestDeadlineFirst) {
+					std::pop_heap(tenant.works.begin(), tenant.works.end(), Later);
+					item = std::move(tenant.works.back());
+					tenant.works.pop_back();
+				} else {
+					item = std::move(tenant.works.front());
+					tenant.works.pop_front();
+				}
+				tenant.running.fetch_add(1, std::memory_order_acq_rel);
+				--tenant.deficit;
+				_size.fetch_sub(1, std::memory_order_release);
+				if (tenant.works.empty()) {
+					tenant.deficit = 0;
+					tenant.scheduled = false;
+					_scheduled.pop_front();
+				} else if (tenant.deficit == 0) {
+					_scheduled.pop_front();
+					_scheduled.push_back(id);
+				}
+				UpdateRunnable(true, Runnable(tenant));
+				handle = &tenant;
+				return true;
+			}
+		}
+
+		// Returns true if the tenant became runnable again, the caller must hold the queue lock when Capped(handle)
+		bool Complete(handle_type handle) {
+			Tenant& tenant = *handle;
+			tenant.completed.fetch_add(1, std::memory_order_relaxed);
+			if (!Capped(handle)) {
+				tenant.running.fetch_sub(1, std::memory_order_acq_rel);
+				return false;
+			}
+			bool runnable = Runnable(tenant);
+			tenant.running.fetch_sub(1, std::memory_order_acq_rel);
+			return UpdateRunnable(runnable, Runnable(tenant));
+		}
+
+		// Gives back a popped task that will never run, caller holds the queue lock
+		void Cancel(handle_type handle) {
+			Tenant& tenant = *handle;
+			bool runnable = Runnable(tenant);
+			tenant.running.fetch_sub(1, std::memory_order_acq_rel);
+			UpdateRunnable(runnable, Runnable(tenant));
+		}
+
+		// Puts a popped task back at the front of its tenant's queue as if it never ran, caller holds the queue lock
+		// Return several in reverse pop order to keep their order, the turn they were popped in stays spent
+		void Return(handle_type handle, item_type item) {
+			Tenant& tenant = *handle;
+			bool runnable = Runnable(tenant);
+			tenant.running.fetch_sub(1, std::memory_order_acq_rel);
+			if (tenant.settings.earliestDeadlineFirst) {
+				Insert(tenant, std::move(item));
+			} else {
+				tenant.works.push_front(std::move(item));
+			}
+			if (!tenant.scheduled) {
+				tenant.scheduled = true;
+				_scheduled.push_back(tenant.id);
+			}
+			_size.fetch_add(1, std::memory_order_release);
+			UpdateRunnable(runnable, Runnable(tenant));
+		}
+
+		TenantMetrics Metrics(TenantId id) const {
+			const Tenant& tenant = *_tenants[id];
+			return TenantMetrics{ id, tenant.settings.name, tenant.settings.weight, tenant.settings.maxConcurrency, tenant.submitted, tenant.completed.load(std::memory_order_relaxed), tenant.works.size(), tenant.peakQueued, tenant.running.load(std::memory_order_relaxed) };
+		}
+	private:
+		// Heap order for earliest deadline first, the front is the earliest
+		static bool Later(const item_type& a, const item_type& b) {
+			return b.deadline < a.deadline;
+		}
+
+		static void Insert(Tenant& tenant, item_type item) {
+			tenant.works.push_back(std::move(item));
+			if (tenant.settings.earliestDeadlineFirst) {
+				std::push_heap(tenant.works.begin(), tenant.works.end(), Later);
+			}
+		}
+
+		static bool Runnable(const Tenant& tenant) {
+			return !tenant.works.empty() && (tenant.settings.maxConcurrency == 0 || tenant.running.load(std::memory_order_acquire) < tenant.settings.maxConcurrency);
+		}
+
+		bool UpdateRunnable(bool before, bool after) {
+			if (before && !after) {
+				_runnable.fetch_sub(1, std::memory_order_release);
+			} else if (!before && after) {
+				_runnable.fetch_add(1, std::memory_order_release);
+				return true;
+			}
+			return false;
+		}
+	};
+}
\ No newline at end of file
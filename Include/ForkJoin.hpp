@@ -0,0 +1,415 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "EpochReclamation.hpp"
+#include "Latch.hpp"
+#include "ThreadSanitizer.hpp"
+
+namespace Threading {
+	class ForkJoin;
+
+	// Child task record, lives in the spawning frame and is never copied or allocated by the scheduler
+	struct ForkJoinJob {
+		void (*execute)(ForkJoinJob*);
+		ForkJoin* group;
+	};
+
+	template <class _FuncTy>
+	class ForkJoinTask : public ForkJoinJob {
+	protected:
+		_FuncTy _functor;
+	public:
+		ForkJoinTask(_FuncTy functor) : ForkJoinJob{ &ForkJoinTask::Run, nullptr }, _functor(std::move(functor)) {
+
+		}
+
+		ForkJoinTask(const ForkJoinTask&) = delete;
+		ForkJoinTask& operator=(const ForkJoinTask&) = delete;
+	private:
+		static void Run(ForkJoinJob* job) {
+			static_cast<ForkJoinTask*>(job)->_functor();
+		}
+	};
+
+	// Chase-Lev deque, the owner pushes and pops at the bottom, thieves steal from the top
+	// The owner doubles the buffer when full, the old one is retired to the epoch domain as thieves may still be reading it
+	class WorkStealingDeque {
+	protected:
+		struct Buffer {
+			std::int64_t mask;
+			std::unique_ptr<std::atomic<ForkJoinJob*>[]> slots;
+
+			Buffer(std::size_t size) : mask((std::int64_t)size - 1), slots(new std::atomic<ForkJoinJob*>[size]) {
+
+			}
+		};
+
+		alignas(64) std::atomic<std::int64_t> _top;
+		alignas(64) std::atomic<std::int64_t> _bottom;
+		std::atomic<Buffer*> _buffer;
+	public:
+		WorkStealingDeque(std::size_t capacity) : _top(0), _bottom(0), _buffer(nullptr) {
+			std::size_t size = 2;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			_buffer.store(new Buffer(size), std::memory_order_relaxed);
+		}
+
+		WorkStealingDeque(const WorkStealingDeque&) = delete;
+		WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+		~WorkStealingDeque() {
+			delete _buffer.load(std::memory_order_relaxed);
+		}
+
+		// Owner only
+		void Push(ForkJoinJob* job, EpochDomain::Participant& participant) {
+			std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+			std::int64_t top = _top.load(std::memory_order_acquire);
+			Buffer* buffer = _buffer.load(std::memory_order_relaxed);
+			if (bottom - top > buffer->mask) {
+				buffer = Grow(buffer, top, bottom, participant);
+			}
+			buffer->slots[bottom & buffer->mask].store(job, std::memory_order_relaxed);
+			// Publishes the record to thieves that acquire _bottom
+			_bottom.store(bottom + 1, std::memory_order_release);
+		}
+
+		// Owner only, newest first
+		ForkJoinJob* Pop() {
+			std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+			Buffer* buffer = _buffer.load(std::memory_order_relaxed);
+#if THREADPOOL_TSAN
+			// ThreadSanitizer does not model fences, a sequentially consistent exchange and load keep the store before the load
+			_bottom.exchange(bottom, std::memory_order_seq_cst);
+			std::int64_t top = _top.load(std::memory_order_seq_cst);
+#else
+			_bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			std::int64_t top = _top.load(std::memory_order_relaxed);
+#endif
+			if (top > bottom) {
+				_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			ForkJoinJob* job = buffer->slots[bottom & buffer->mask].load(std::memory_order_relaxed);
+			if (top == bottom) {
+				// Last job, race thieves for it
+				if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					job = nullptr;
+				}
+				_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		// Any thread, oldest first, returns nullptr when empty or on a lost race
+		ForkJoinJob* Steal(EpochDomain::Participant& participant) {
+			EpochDomain::Guard guard(participant);
+#if THREADPOOL_TSAN
+			std::int64_t top = _top.load(std::memory_order_seq_cst);
+			std::int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+#else
+			std::int64_t top = _top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			std::int64_t bottom = _bottom.load(std::memory_order_acquire);
+#endif
+			if (top >= bottom) {
+				return nullptr;
+			}
+			Buffer* buffer = _buffer.load(std::memory_order_acquire);
+			ForkJoinJob* job = buffer->slots[top & buffer->mask].load(std::memory_order_relaxed);
+			if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return job;
+		}
+
+		bool Empty() const {
+			return _top.load(std::memory_order_seq_cst) >= _bottom.load(std::memory_order_seq_cst);
+		}
+
+		std::size_t Capacity() const {
+			return (std::size_t)_buffer.load(std::memory_order_acquire)->mask + 1;
+		}
+	private:
+		Buffer* Grow(Buffer* buffer, std::int64_t top, std::int64_t bottom, EpochDomain::Participant& participant) {
+			Buffer* grown = new Buffer((std::size_t)(buffer->mask + 1) * 2);
+			for (std::int64_t i = top; i < bottom; ++i) {
+				grown->slots[i & grown->mask].store(buffer->slots[i & buffer->mask].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+			_buffer.store(grown, std::memory_order_release);
+			// Entries in the old buffer never change, a thief reading it still sees the right job
+			participant.Retire(buffer);
+			return grown;
+		}
+	};
+
+	// Work-stealing pool for recursive parallelism, every worker owns a deque of child records spawned on it
+	// Idle workers steal the oldest record from a random victim, an unstolen child is run inline by Sync (work-first)
+	class ForkJoinPool {
+	public:
+		using thread_type = std::thread;
+		using thread_container = std::vector<thread_type>;
+		using lock_type = std::unique_lock<std::mutex>;
+
+		// Initial per-worker capacity, deques grow as needed
+		static constexpr std::size_t DefaultDequeCapacity = 1 << 8;
+		// Idle workers try to steal this many times before sleeping
+		static constexpr std::size_t SpinCount = 64;
+
+		// Identifies the pool and worker running on the calling thread, pool is nullptr outside workers
+		struct WorkerContext {
+			ForkJoinPool* pool;
+			std::size_t index;
+		};
+	protected:
+		// Declared first so retired buffers are freed after every deque and participant is gone
+		EpochDomain _domain;
+		// One per worker, only that worker steals or grows its deque
+		std::vector<std::unique_ptr<EpochDomain::Participant>> _participants;
+		std::vector<std::unique_ptr<WorkStealingDeque>> _deques;
+		std::mutex _mutex;
+		std::condition_variable _conditionVariable;
+		std::deque<ForkJoinJob*> _injected;
+		// Lets idle workers skip _mutex while nothing is injected
+		std::atomic_size_t _injectedCount;
+		std::atomic_size_t _sleepingThreads;
+		std::atomic_bool _run;
+		thread_container _threads;
+	public:
+		ForkJoinPool(std::size_t numberThreads, std::size_t dequeCapacity = DefaultDequeCapacity) : _injectedCount(0), _sleepingThreads(0), _run(true) {
+			numberThreads = numberThreads ? numberThreads : 1;
+			for (std::size_t i = 0; i < numberThreads; ++i) {
+				_participants.emplace_back(new EpochDomain::Participant(_domain));
+				_deques.emplace_back(new WorkStealingDeque(dequeCapacity));
+			}
+			for (std::size_t i = 0; i < numberThreads; ++i) {
+				_threads.push_back(thread_type(&ForkJoinPool::FunctionWrapper, this, i));
+			}
+		}
+
+		ForkJoinPool(const ForkJoinPool&) = delete;
+		ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+		~ForkJoinPool() {
+			{
+				lock_type lock(_mutex);
+				_run.store(false, std::memory_order_release);
+			}
+			_conditionVariable.notify_all();
+			for (thread_type& t : _threads) {
+				if (t.joinable()) {
+					t.join();
+				}
+			}
+		}
+
+		// Runs functor on a worker and returns once it and every child it spawned have completed
+		template <class _FuncTy>
+		void Run(_FuncTy functor) {
+			if (CurrentWorker().pool == this) {
+				// Already on a worker, blocking it on the latch could leave nobody to run the root
+				functor();
+				return;
+			}
+			Latch latch(1);
+			auto body = [&functor, &latch]() { functor(); latch.CountDown(); };
+			ForkJoinTask<decltype(body)> root(body);
+			{
+				lock_type lock(_mutex);
+				_injected.push_back(&root);
+				_injectedCount.fetch_add(1, std::memory_order_release);
+			}
+			_conditionVariable.notify_one();
+			latch.Wait();
+		}
+
+		std::size_t Size() const {
+			return _threads.size();
+		}
+
+		// Deque buffers outgrown while thieves may still read them
+		EpochMetrics GetReclamationMetrics() const {
+			return _domain.GetMetrics();
+		}
+
+		static WorkerContext& CurrentWorker() {
+			thread_local WorkerContext context{ nullptr, 0 };
+			return context;
+		}
+
+		// Called by ForkJoin on worker index
+		void Spawn(std::size_t index, ForkJoinJob* job) {
+			_deques[index]->Push(job, *_participants[index]);
+			// Pairs with the sleeper's increment before its recheck, either it sees the job or this sees the sleeper
+#if THREADPOOL_TSAN
+			if (_sleepingThreads.fetch_add(0, std::memory_order_seq_cst) != 0) {
+#else
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (_sleepingThreads.load(std::memory_order_relaxed) != 0) {
+#endif
+				lock_type lock(_mutex);
+				_conditionVariable.notify_one();
+			}
+		}
+
+		ForkJoinJob* Pop(std::size_t index) {
+			return _deques[index]->Pop();
+		}
+
+		// Steals from every other worker once starting at a random victim, then from jobs injected by Run
+		ForkJoinJob* Steal(std::size_t index) {
+			thread_local std::uint64_t state = 0x9E3779B97F4A7C15ull ^ (std::uint64_t)(std::uintptr_t)&state;
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			std::size_t size = _deques.size();
+			std::size_t start = (std::size_t)(state % size);
+			for (std::size_t i = 0; i < size; ++i) {
+				std::size_t victim = (start + i) % size;
+				if (victim == index) {
+					continue;
+				}
+				ForkJoinJob* job = _deques[victim]->Steal(*_participants[index]);
+				if (job != nullptr) {
+					return job;
+				}
+			}
+			if (_injectedCount.load(std::memory_order_acquire) == 0) {
+				return nullptr;
+			}
+			lock_type lock(_mutex);
+			if (_injected.empty()) {
+				return nullptr;
+			}
+			ForkJoinJob* job = _injected.front();
+			_injected.pop_front();
+			_injectedCount.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+
+		static void Execute(ForkJoinJob* job);
+	private:
+		bool Idle() const {
+			if (!_injected.empty()) {
+				return false;
+			}
+			for (const auto& deque : _deques) {
+				if (!deque->Empty()) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void FunctionWrapper(std::size_t index) {
+			CurrentWorker() = WorkerContext{ this, index };
+			std::size_t spins = 0;
+			while (_run.load(std::memory_order_acquire)) {
+				ForkJoinJob* job = Steal(index);
+				if (job != nullptr) {
+					Execute(job);
+					spins = 0;
+					continue;
+				}
+				if (++spins < SpinCount) {
+					std::this_thread::yield();
+					continue;
+				}
+				lock_type lock(_mutex);
+				_sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+				_conditionVariable.wait(lock, [this]() { return !_run.load(std::memory_order_acquire) || !Idle(); });
+				_sleepingThreads.fetch_sub(1, std::memory_order_relaxed);
+				spins = 0;
+			}
+		}
+	};
+
+	// Spawn / Sync scope for one parent frame, children must outlive the matching Sync
+	// Outside a ForkJoinPool worker Spawn runs the child immediately
+	class ForkJoin {
+		friend class ForkJoinPool;
+	protected:
+		ForkJoinPool::WorkerContext _context;
+		// Children pushed since the last Sync and not yet reclaimed by it
+		std::size_t _spawned;
+		// Children completed by thieves, the only shared state
+		std::atomic_size_t _stolen;
+	public:
+		ForkJoin() : _context(ForkJoinPool::CurrentWorker()), _spawned(0), _stolen(0) {
+
+		}
+
+		ForkJoin(const ForkJoin&) = delete;
+		ForkJoin& operator=(const ForkJoin&) = delete;
+
+		~ForkJoin() {
+			Sync();
+		}
+
+		void Spawn(ForkJoinJob& child) {
+			child.group = this;
+			if (_context.pool == nullptr) {
+				child.execute(&child);
+				return;
+			}
+			_context.pool->Spawn(_context.index, &child);
+			++_spawned;
+		}
+
+		// Runs unstolen children inline newest first, then helps other workers until stolen children complete
+		void Sync() {
+			if (_spawned == 0) {
+				return;
+			}
+			// Younger than anything an enclosing frame spawned, so every job popped here belongs to this scope
+			while (_spawned != 0) {
+				ForkJoinJob* job = _context.pool->Pop(_context.index);
+				if (job == nullptr) {
+					break;
+				}
+				--_spawned;
+				job->execute(job);
+			}
+			while (_stolen.load(std::memory_order_acquire) != _spawned) {
+				ForkJoinJob* job = _context.pool->Steal(_context.index);
+				if (job != nullptr) {
+					ForkJoinPool::Execute(job);
+				} else {
+					std::this_thread::yield();
+				}
+			}
+			_spawned = 0;
+			_stolen.store(0, std::memory_order_relaxed);
+		}
+
+		// Runs first as a child and second inline, returns once both completed
+		template <class _FirstTy, class _SecondTy>
+		static void Invoke(_FirstTy first, _SecondTy second) {
+			ForkJoinTask<_FirstTy> child(std::move(first));
+			ForkJoin scope;
+			scope.Spawn(child);
+			second();
+			scope.Sync();
+		}
+	};
+
+	// Runs a stolen or injected job, the increment is the last access to the spawning frame
+	inline void ForkJoinPool::Execute(ForkJoinJob* job) {
+		ForkJoin* group = job->group;
+		job->execute(job);
+		if (group != nullptr) {
+			group->_stolen.fetch_add(1, std::memory_order_release);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ThreadPoolCPP.hpp"
+
+namespace Threading {
+	struct HillClimbingSettings {
+		std::size_t minThreads = 1;
+		// Clamped to the threadpool size, construct the threadpool with the largest count the controller may use
+		std::size_t maxThreads = ~(std::size_t)0;
+		std::chrono::milliseconds sampleInterval = std::chrono::milliseconds(100);
+		// Throughput is averaged over this many samples before each move
+		std::size_t samplesPerMove = 3;
+		// Relative throughput change treated as noise
+		double tolerance = 0.05;
+		std::size_t stepSize = 1;
+		std::size_t historySize = 64;
+	};
+
+	// Adjusts a threadpool's active worker count to maximise completed tasks per second
+	// The controller keeps moving in one direction while throughput improves and reverses when it drops
+	template <class _PoolTy = ThreadPoolCPP>
+	class HillClimbing {
+	public:
+		using threadpool_type = _PoolTy;
+		using clock_type = std::chrono::steady_clock;
+		using lock_type = std::unique_lock<std::mutex>;
+
+		enum class Reason {
+			Initial,
+			Improved,
+			Degraded,
+			Flat,
+			Idle
+		};
+
+		struct Decision {
+			clock_type::time_point time;
+			Reason reason;
+			double throughput;
+			std::size_t previousThreads;
+			std::size_t threads;
+		};
+
+		struct Metrics {
+			std::uint64_t samples;
+			std::uint64_t moves;
+			double throughput;
+			std::size_t activeThreads;
+			std::vector<Decision> history;
+		};
+	protected:
+		threadpool_type& _threadpool;
+		HillClimbingSettings _settings;
+		bool _run;
+		std::mutex _mutex;
+		std::condition_variable _conditionVariable;
+		std::uint64_t _samples;
+		std::uint64_t _moves;
+		double _throughput;
+		std::deque<Decision> _history;
+		std::thread _thread;
+	public:
+		HillClimbing(threadpool_type& threadpool, HillClimbingSettings settings = HillClimbingSettings()) : _threadpool(threadpool), _settings(settings), _run(true), _samples(0), _moves(0), _throughput(0) {
+			_settings.maxThreads = _settings.maxThreads > _threadpool.Size() ? _threadpool.Size() : _settings.maxThreads;
+			_settings.minThreads = _settings.minThreads < 1 ? 1 : (_settings.minThreads > _settings.maxThreads ? _settings.maxThreads : _settings.minThreads);
+			_settings.samplesPerMove = _settings.samplesPerMove ? _settings.samplesPerMove : 1;
+			_settings.stepSize = _settings.stepSize ? _settings.stepSize : 1;
+			_thread = std::thread(&HillClimbing::Controller, this);
+		}
+
+		HillClimbing(const HillClimbing&) = delete;
+		HillClimbing& operator=(const HillClimbing&) = delete;
+
+		// Stops the controller, the threadpool keeps its last active thread count
+		~HillClimbing() {
+			{
+				lock_type lock(_mutex);
+				_run = false;
+			}
+			_conditionVariable.notify_all();
+			_thread.join();
+		}
+
+		const HillClimbingSettings& Settings() const {
+			return _settings;
+		}
+
+		Metrics GetMetrics() {
+			lock_type lock(_mutex);
+			return Metrics{ _samples, _moves, _throughput, _threadpool.ActiveThreads(), std::vector<Decision>(_history.begin(), _history.end()) };
+		}
+	private:
+		void Controller() {
+			std::size_t threads = Clamp(_threadpool.ActiveThreads());
+			_threadpool.SetActiveThreads(threads);
+			Record(Reason::Initial, 0, threads, threads);
+
+			long direction = 1;
+			double baseline = -1;
+			double accumulated = 0;
+			std::size_t samples = 0;
+			std::uint64_t lastCompleted = _threadpool.CompletedTasks();
+			clock_type::time_point lastTime = clock_type::now();
+
+			lock_type lock(_mutex);
+			while (_run) {
+				_conditionVariable.wait_for(lock, _settings.sampleInterval, [this]() { return !_run; });
+				if (!_run) {
+					break;
+				}
+
+				std::uint64_t completed = _threadpool.CompletedTasks();
+				clock_type::time_point now = clock_type::now();
+				double seconds = std::chrono::duration<double>(now - lastTime).count();
+				double sample = seconds > 0 ? (completed - lastCompleted) / seconds : 0;
+				lastCompleted = completed;
+				lastTime = now;
+				++_samples;
+				_throughput = sample;
+
+				accumulated += sample;
+				if (++samples < _settings.samplesPerMove) {
+					continue;
+				}
+				double throughput = accumulated / samples;
+				accumulated = 0;
+				samples = 0;
+
+				// Without queued work throughput measures demand, not concurrency
+				if (_threadpool.QueuedTasks() == 0) {
+					baseline = -1;
+					RecordLocked(Reason::Idle, throughput, threads, threads);
+					continue;
+				}
+
+				Reason reason = Reason::Initial;
+				if (baseline < 0) {
+					// First measurement at this load, probe upwards
+					direction = 1;
+				} else if (throughput > baseline * (1 + _settings.tolerance)) {
+					reason = Reason::Improved;
+				} else if (throughput < baseline * (1 - _settings.tolerance)) {
+					reason = Reason::Degraded;
+					direction = -direction;
+				} else {
+					// No measurable gain, prefer fewer threads
+					reason = Reason::Flat;
+					direction = -1;
+				}
+				baseline = throughput;
+
+				std::size_t previous = threads;
+				if (direction > 0) {
+					threads = Clamp(threads + _settings.stepSize);
+				} else {
+					threads = Clamp(threads > _settings.stepSize ? threads - _settings.stepSize : 0);
+				}
+				// Bounce off the limits so the controller keeps probing
+				if (threads == previous) {
+					direction = -direction;
+				} else {
+					++_moves;
+					_threadpool.SetActiveThreads(threads);
+				}
+				RecordLocked(reason, throughput, previous, threads);
+			}
+		}
+
+		std::size_t Clamp(std::size_t threads) const {
+			return threads < _settings.minThreads ? _settings.minThreads : (threads > _settings.maxThreads ? _settings.maxThreads : threads);
+		}
+
+		void Record(Reason reason, double throughput, std::size_t previous, std::size_t threads) {
+			lock_type lock(_mutex);
+			RecordLocked(reason, throughput, previous, threads);
+		}
+
+		void RecordLocked(Reason reason, double throughput, std::size_t previous, std::size_t threads) {
+			_history.push_back(Decision{ clock_type::now(), reason, throughput, previous, threads });
+			while (_history.size() > _settings.historySize) {
+				_history.pop_front();
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Threading {
+	struct ArenaStats {
+		std::size_t chunks;
+		// Chunks mapped with explicit huge pages (MAP_HUGETLB or MEM_LARGE_PAGES)
+		std::size_t hugeChunks;
+		// Chunks on normal pages that were advised to use transparent huge pages
+		std::size_t advisedChunks;
+		std::size_t mappedBytes;
+		std::size_t allocatedBytes;
+		// Bytes handed back to the system by Trim over the arena's lifetime, pages released again before anything touched them count once
+		std::size_t trimmedBytes;
+	};
+
+	// Size-class arena carved from large chunks mapped with huge pages when the system allows it, normal pages otherwise
+	// Freed blocks go to a per-class free list and are reused, Trim returns free pages to the system and destruction unmaps everything
+	// Not thread safe, use one per thread or guard it with a lock
+	class HugePageArena {
+	public:
+		static constexpr std::size_t HugePageSize = 2 << 20;
+		static constexpr std::size_t DefaultChunkSize = HugePageSize;
+		static constexpr std::size_t MinimumBlock = 16;
+		// Larger blocks or stricter alignment go straight to operator new
+		static constexpr std::size_t MaximumAlignment = 64;
+		// Granularity Trim releases memory at
+		static constexpr std::size_t PageSize = 4096;
+	protected:
+		struct FreeBlock {
+			FreeBlock* next;
+			// Trim released the pages after the first one, cleared when the block is freed again
+			bool trimmed;
+		};
+
+		struct Chunk {
+			void* memory;
+			std::size_t size;
+			bool huge;
+			// Pages from here to the end of the chunk were not touched since the last full Trim
+			unsigned char* carvedEnd;
+			// Bytes below carvedEnd that Trim released inside free blocks and nothing touched since
+			std::size_t cleanBytes;
+		};
+
+		std::size_t _chunkSize;
+		std::size_t _maximumBlock;
+		std::vector<Chunk> _chunks;
+		// Chunk the cursor carves from, chunks after it are mapped but unused since the last full Trim
+		std::size_t _current;
+		std::vector<FreeBlock*> _freeLists;
+		unsigned char* _cursor;
+		unsigned char* _end;
+		ArenaStats _stats;
+	public:
+		HugePageArena(std::size_t chunkSize = DefaultChunkSize) : _chunkSize(RoundUp(chunkSize ? chunkSize : DefaultChunkSize, HugePageSize)), _current(0), _cursor(nullptr), _end(nullptr), _stats{ 0, 0, 0, 0, 0, 0 } {
+			_maximumBlock = _chunkSize / 4;
+			std::size_t classes = 0;
+			for (std::size_t size = MinimumBlock; size <= _maximumBlock; size <<= 1) {
+				++classes;
+			}
+			_freeLists.assign(classes, nullptr);
+		}
+
+		HugePageArena(const HugePageArena&) = delete;
+		HugePageArena& operator=(const HugePageArena&) = delete;
+
+		~HugePageArena() {
+			for (Chunk& chunk : _chunks) {
+				Unmap(chunk);
+			}
+		}
+
+		void* Allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+			if (size > _maximumBlock || alignment > MaximumAlignment) {
+				return ::operator new(size, std::align_val_t(alignment));
+			}
+			// A block is aligned to its size up to MaximumAlignment, so the class must be at least the alignment
+			std::size_t index = ClassIndex(size > alignment ? size : alignment);
+			std::size_t blockSize = MinimumBlock << index;
+			_stats.allocatedBytes += blockSize;
+			FreeBlock*& head = _freeLists[index];
+			if (head != nullptr) {
+				FreeBlock* block = head;
+				head = block->next;
+				if (block->trimmed) {
+					// The caller faults the released pages back in
+					ChunkOf(block).cleanBytes -= TrimmableBytes(block, blockSize);
+				}
+				return block;
+			}
+			std::size_t blockAlignment = blockSize < MaximumAlignment ? blockSize : MaximumAlignment;
+			unsigned char* block = AlignUp(_cursor, blockAlignment);
+			if (_cursor == nullptr || block + blockSize > _end) {
+				NextChunk();
+				block = AlignUp(_cursor, blockAlignment);
+			}
+			_cursor = block + blockSize;
+			Chunk& chunk = _chunks[_current];
+			if (_cursor > chunk.carvedEnd) {
+				chunk.carvedEnd = AlignUp(_cursor, PageSize);
+			}
+			return block;
+		}
+
+		// Size and alignment must match the Allocate call
+		void Deallocate(void* pointer, std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+			if (pointer == nullptr) {
+				return;
+			}
+			if (size > _maximumBlock || alignment > MaximumAlignment) {
+				::operator delete(pointer, std::align_val_t(alignment));
+				return;
+			}
+			std::size_t index = ClassIndex(size > alignment ? size : alignment);
+			_stats.allocatedBytes -= MinimumBlock << index;
+			FreeBlock* block = static_cast<FreeBlock*>(pointer);
+			block->next = _freeLists[index];
+			block->trimmed = false;
+			_freeLists[index] = block;
+		}
+
+		std::size_t ChunkSize() const {
+			return _chunkSize;
+		}
+
+		ArenaStats Stats() const {
+			return _stats;
+		}
+
+		// Returns free memory to the system but keeps it mapped, released contents are undefined afterwards and never read
+		// Linux (MADV_DONTNEED) faults zeroed pages back in, Windows (MEM_RESET) may hand back the old data or zeros
+		// With no live blocks every carved page is released and carving restarts at the first chunk
+		// Otherwise only whole pages inside large free blocks go back, small free blocks stay resident
+		// Pages past the cursor were never touched since the last Trim and need no release
+		// Returns the bytes released that were touched since the last Trim, a second Trim with nothing in between returns zero
+		// Huge page chunks (MAP_HUGETLB, MEM_LARGE_PAGES) only release whole chunks or nothing
+		std::size_t Trim() {
+			std::size_t released = 0;
+			if (_chunks.empty()) {
+				return 0;
+			}
+			if (_stats.allocatedBytes == 0) {
+				for (Chunk& chunk : _chunks) {
+					unsigned char* memory = static_cast<unsigned char*>(chunk.memory);
+					std::size_t touched = chunk.carvedEnd - memory;
+					if (touched == 0 || Release(chunk, memory, chunk.huge ? chunk.size : touched) == 0) {
+						continue;
+					}
+					released += chunk.huge ? RoundUp(touched, HugePageSize) : touched - chunk.cleanBytes;
+					chunk.carvedEnd = memory;
+					chunk.cleanBytes = 0;
+				}
+				_freeLists.assign(_freeLists.size(), nullptr);
+				_current = 0;
+				_cursor = static_cast<unsigned char*>(_chunks[0].memory);
+				_end = _cursor + _chunkSize;
+			} else {
+				for (std::size_t index = 0; index < _freeLists.size(); ++index) {
+					std::size_t blockSize = MinimumBlock << index;
+					if (blockSize < 2 * PageSize) {
+						continue;
+					}
+					// The first page keeps the free list link
+					for (FreeBlock* block = _freeLists[index]; block != nullptr; block = block->next) {
+						if (block->trimmed) {
+							continue;
+						}
+						Chunk& chunk = ChunkOf(block);
+						std::size_t size = Release(chunk, AlignUp(reinterpret_cast<unsigned char*>(block) + sizeof(FreeBlock), PageSize), TrimmableBytes(block, blockSize));
+						block->trimmed = size != 0;
+						chunk.cleanBytes += size;
+						released += size;
+					}
+				}
+			}
+			_stats.trimmedBytes += released;
+			return released;
+		}
+	private:
+		static std::size_t RoundUp(std::size_t value, std::size_t multiple) {
+			return (value + multiple - 1) / multiple * multiple;
+		}
+
+		static unsigned char* AlignUp(unsigned char* pointer, std::size_t alignment) {
+			return reinterpret_cast<unsigned char*>((reinterpret_cast<std::uintptr_t>(pointer) + alignment - 1) & ~(std::uintptr_t)(alignment - 1));
+		}
+
+		static std::size_t ClassIndex(std::size_t size) {
+			std::size_t index = 0;
+			while ((MinimumBlock << index) < size) {
+				++index;
+			}
+			return index;
+		}
+
+		// Reuses chunks released by a full Trim before mapping a new one
+		void NextChunk() {
+			if (_cursor != nullptr && _current + 1 < _chunks.size()) {
+				++_current;
+				_cursor = static_cast<unsigned char*>(_chunks[_current].memory);
+				_end = _cursor + _chunkSize;
+				return;
+			}
+			MapChunk();
+		}
+
+		// Whole pages of a free block after the first one, which keeps the free list link
+		static std::size_t TrimmableBytes(FreeBlock* block, std::size_t blockSize) {
+			unsigned char* first = AlignUp(reinterpret_cast<unsigned char*>(block) + sizeof(FreeBlock), PageSize);
+			unsigned char* last = reinterpret_cast<unsigned char*>(block) + blockSize;
+			return first < last ? (last - first) / PageSize * PageSize : 0;
+		}
+
+		Chunk& ChunkOf(void* pointer) {
+			unsigned char* address = static_cast<unsigned char*>(pointer);
+			for (Chunk& chunk : _chunks) {
+				unsigned char* memory = static_cast<unsigned char*>(chunk.memory);
+				if (address >= memory && address < memory + chunk.size) {
+					return chunk;
+				}
+			}
+			return _chunks[_current];
+		}
+
+		// Returns the bytes released, partial ranges of huge page chunks cannot be released
+		static std::size_t Release(Chunk& chunk, unsigned char* memory, std::size_t size) {
+			size = size / PageSize * PageSize;
+			if (size == 0 || (chunk.huge && size != chunk.size)) {
+				return 0;
+			}
+#if defined(_WIN32)
+			// Large pages cannot be reset, the call fails and nothing is released
+			return VirtualAlloc(memory, size, MEM_RESET, PAGE_READWRITE) != nullptr ? size : 0;
+#else
+			return madvise(memory, size, MADV_DONTNEED) == 0 ? size : 0;
+#endif
+		}
+
+		void MapChunk() {
+			Chunk chunk{ nullptr, _chunkSize, false, nullptr, 0 };
+			bool advised = false;
+#if defined(_WIN32)
+			// Large pages need SeLockMemoryPrivilege, without it the call fails and normal pages are used
+			SIZE_T largePage = GetLargePageMinimum();
+			if (largePage != 0 && _chunkSize % largePage == 0) {
+				chunk.memory = VirtualAlloc(nullptr, _chunkSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+				chunk.huge = chunk.memory != nullptr;
+			}
+			if (chunk.memory == nullptr) {
+				chunk.memory = VirtualAlloc(nullptr, _chunkSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			}
+#else
+#if defined(MAP_HUGETLB)
+			// Only succeeds when huge pages have been reserved (vm.nr_hugepages)
+			chunk.memory = mmap(nullptr, _chunkSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			chunk.huge = chunk.memory != MAP_FAILED;
+#endif
+			if (!chunk.huge) {
+				chunk.memory = mmap(nullptr, _chunkSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+				advised = chunk.memory != MAP_FAILED && madvise(chunk.memory, _chunkSize, MADV_HUGEPAGE) == 0;
+#endif
+			}
+			if (chunk.memory == MAP_FAILED) {
+				chunk.memory = nullptr;
+			}
+#endif
+			if (chunk.memory == nullptr) {
+				throw std::bad_alloc();
+			}
+			chunk.carvedEnd = static_cast<unsigned char*>(chunk.memory);
+			_chunks.push_back(chunk);
+			_current = _chunks.size() - 1;
+			_stats.chunks += 1;
+			_stats.hugeChunks += chunk.huge ? 1 : 0;
+			_stats.advisedChunks += advised ? 1 : 0;
+			_stats.mappedBytes += _chunkSize;
+			_cursor = static_cast<unsigned char*>(chunk.memory);
+			_end = _cursor + _chunkSize;
+		}
+
+		static void Unmap(Chunk& chunk) {
+#if defined(_WIN32)
+			VirtualFree(chunk.memory, 0, MEM_RELEASE);
+#else
+			munmap(chunk.memory, chunk.size);
+#endif
+		}
+	};
+
+	// Standard allocator over a HugePageArena, a null arena falls back to operator new with the type's alignment like std::allocator
+	template <class _ValueTy>
+	class ArenaAllocator {
+		template <class _OtherTy>
+		friend class ArenaAllocator;
+	public:
+		using value_type = _ValueTy;
+	protected:
+		HugePageArena* _arena;
+	public:
+		ArenaAllocator(HugePageArena* arena = nullptr) noexcept : _arena(arena) {
+
+		}
+
+		template <class _OtherTy>
+		ArenaAllocator(const ArenaAllocator<_OtherTy>& other) noexcept : _arena(other._arena) {
+
+		}
+
+		value_type* allocate(std::size_t count) {
+			if (_arena == nullptr) {
+				if (alignof(value_type) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+					return static_cast<value_type*>(::operator new(count * sizeof(value_type), std::align_val_t(alignof(value_type))));
+				}
+				return static_cast<value_type*>(::operator new(count * sizeof(value_type)));
+			}
+			return static_cast<value_type*>(_arena->Allocate(count * sizeof(value_type), alignof(value_type)));
+		}
+
+		void deallocate(value_type* pointer, std::size_t count) noexcept {
+			if (_arena == nullptr) {
+				if (alignof(value_type) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+					::operator delete(pointer, std::align_val_t(alignof(value_type)));
+				} else {
+					::operator delete(pointer);
+				}
+				return;
+			}
+			_arena->Deallocate(pointer, count * sizeof(value_type), alignof(value_type));
+		}
+
+		HugePageArena* Arena() const noexcept {
+			return _arena;
+		}
+
+		template <class _OtherTy>
+		bool operator==(const ArenaAllocator<_OtherTy>& other) const noexcept {
+			return _arena == other._arena;
+		}
+
+		template <class _OtherTy>
+		bool operator!=(const ArenaAllocator<_OtherTy>& other) const noexcept {
+			return _arena != other._arena;
+		}
+	};
+}
\ No newline at end of file
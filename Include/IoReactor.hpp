@@ -0,0 +1,215 @@
+#pragma once
+
+#if defined(__linux__)
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "ThreadPoolCPP.hpp"
+
+namespace Threading {
+	// Readiness notifications for sockets, pipes and other pollable descriptors, polled by tasks on a ThreadPoolCPP
+	// Each poller blocks in epoll_wait inside a BlockingScope and pushes every batch of completions with one PushBatch
+	// Every poller holds a worker for the reactor's lifetime and is covered by a spare, so the threadpool needs maxSpareThreads of at least the poller count
+	// ThreadPoolCPP::Wait and Shutdown(Drain) do not return while the reactor runs, Stop it first
+	// Stop and the destructor wait for handlers already pushed, so a handler may use the reactor and whatever outlives it
+	class IoReactor {
+	public:
+		using lock_type = std::unique_lock<std::mutex>;
+		// Descriptor and the epoll events that fired
+		using handler_type = std::function<void(int, std::uint32_t)>;
+
+		static constexpr std::size_t MaxEvents = 64;
+		static constexpr const char* Label = "io";
+	protected:
+		struct Registration {
+			int fd;
+			std::uint32_t events;
+			handler_type handler;
+		};
+
+		// Shared with the poller tasks, which may still be queued when the reactor is destroyed
+		struct State {
+			int epoll;
+			int wake;
+			bool running;
+			std::size_t polling;
+			// Handlers pushed to the threadpool that have not returned yet
+			std::size_t handling;
+			std::mutex mutex;
+			std::condition_variable stopped;
+			std::unordered_map<int, std::shared_ptr<Registration>> registrations;
+
+			State() : epoll(epoll_create1(EPOLL_CLOEXEC)), wake(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), running(true), polling(0), handling(0) {
+
+			}
+
+			~State() {
+				if (wake >= 0) {
+					close(wake);
+				}
+				if (epoll >= 0) {
+					close(epoll);
+				}
+			}
+		};
+
+		ThreadPoolCPP& _threadpool;
+		TenantId _tenant;
+		std::shared_ptr<State> _state;
+	public:
+		// Handlers run as tasks of tenant, one poller is enough unless a single epoll_wait cannot keep up
+		// Stop or destroy the reactor before shutting the threadpool down, a running poller keeps it from draining
+		// Throws std::invalid_argument when the threadpool has fewer spare threads than pollers
+		IoReactor(ThreadPoolCPP& threadpool, std::size_t pollers = 1, TenantId tenant = DefaultTenant) : _threadpool(threadpool), _tenant(tenant), _state(new State()) {
+			pollers = pollers ? pollers : 1;
+			if (pollers > _threadpool.SpareThreads()) {
+				throw std::invalid_argument("IoReactor: maxSpareThreads is below the poller count");
+			}
+			if (_state->epoll < 0 || _state->wake < 0) {
+				throw std::system_error(errno, std::generic_category(), "IoReactor");
+			}
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.fd = _state->wake;
+			epoll_ctl(_state->epoll, EPOLL_CTL_ADD, _state->wake, &event);
+			for (std::size_t i = 0; i < pollers; ++i) {
+				_threadpool.PushTenantLabelled(_tenant, Label, &IoReactor::Poll, &_threadpool, _tenant, _state);
+			}
+		}
+
+		IoReactor(const IoReactor&) = delete;
+		IoReactor& operator=(const IoReactor&) = delete;
+
+		~IoReactor() {
+			Stop();
+		}
+
+		// Registrations are one-shot, the handler runs once per readiness and Rearm enables the next notification
+		// This keeps a descriptor's handler from running on two workers at once, returns false with errno set on failure
+		bool Add(int fd, std::uint32_t events, handler_type handler) {
+			lock_type lock(_state->mutex);
+			std::shared_ptr<Registration> registration(new Registration{ fd, events, std::move(handler) });
+			epoll_event event{};
+			event.events = events | EPOLLONESHOT;
+			event.data.fd = fd;
+			if (epoll_ctl(_state->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+				return false;
+			}
+			_state->registrations[fd] = registration;
+			return true;
+		}
+
+		bool Rearm(int fd) {
+			lock_type lock(_state->mutex);
+			auto found = _state->registrations.find(fd);
+			if (found == _state->registrations.end()) {
+				errno = ENOENT;
+				return false;
+			}
+			epoll_event event{};
+			event.events = found->second->events | EPOLLONESHOT;
+			event.data.fd = fd;
+			return epoll_ctl(_state->epoll, EPOLL_CTL_MOD, fd, &event) == 0;
+		}
+
+		// Handlers already pushed may still run, the descriptor must stay open until Remove returns
+		bool Remove(int fd) {
+			lock_type lock(_state->mutex);
+			if (_state->registrations.erase(fd) == 0) {
+				errno = ENOENT;
+				return false;
+			}
+			return epoll_ctl(_state->epoll, EPOLL_CTL_DEL, fd, nullptr) == 0;
+		}
+
+		// Returns once no poller is inside epoll_wait and every pushed handler returned
+		// The threadpool must keep running tasks until then, and a handler must not call Stop itself
+		void Stop() {
+			lock_type lock(_state->mutex);
+			if (_state->running) {
+				_state->running = false;
+				std::uint64_t one = 1;
+				// Level-triggered and never drained, so every poller wakes
+				ssize_t written = write(_state->wake, &one, sizeof(one));
+				(void)written;
+			}
+			_state->stopped.wait(lock, [this]() { return _state->polling == 0 && _state->handling == 0; });
+		}
+	private:
+		static void Poll(ThreadPoolCPP* threadpool, TenantId tenant, std::shared_ptr<State> state) {
+			{
+				lock_type lock(state->mutex);
+				if (!state->running) {
+					return;
+				}
+				++state->polling;
+			}
+			BlockingScope scope;
+			epoll_event events[MaxEvents];
+			std::vector<ThreadPoolCPP::work_type> works;
+			works.reserve(MaxEvents);
+			for (;;) {
+				int count = epoll_wait(state->epoll, events, (int)MaxEvents, -1);
+				if (count < 0 && errno == EINTR) {
+					continue;
+				}
+				lock_type lock(state->mutex);
+				if (count < 0 || !state->running) {
+					break;
+				}
+				for (int i = 0; i < count; ++i) {
+					auto found = state->registrations.find(events[i].data.fd);
+					if (found == state->registrations.end()) {
+						continue;
+					}
+					std::shared_ptr<Registration> registration = found->second;
+					std::uint32_t fired = events[i].events;
+					works.push_back([state, registration, fired]() { Dispatch(*state, *registration, fired); });
+				}
+				state->handling += works.size();
+				lock.unlock();
+				try {
+					threadpool->PushBatch(works, tenant, Label);
+				} catch (...) {
+					// PushBatch leaves the handlers it did not queue in works
+					lock.lock();
+					state->handling -= works.size();
+					--state->polling;
+					state->stopped.notify_all();
+					throw;
+				}
+			}
+			lock_type lock(state->mutex);
+			--state->polling;
+			state->stopped.notify_all();
+		}
+
+		static void Dispatch(State& state, Registration& registration, std::uint32_t fired) {
+			try {
+				registration.handler(registration.fd, fired);
+			} catch (...) {
+				Finish(state);
+				throw;
+			}
+			Finish(state);
+		}
+
+		static void Finish(State& state) {
+			lock_type lock(state.mutex);
+			--state.handling;
+			state.stopped.notify_all();
+		}
+	};
+}
+#endif
\ No newline at end of file
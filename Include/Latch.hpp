@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include "ThreadPoolCPP.hpp"
+
+namespace Threading {
+	// Single-use countdown, the waiting thread sleeps until CountDown has been called count times
+	class Latch {
+	public:
+		using lock_type = std::unique_lock<std::mutex>;
+	protected:
+		std::atomic_size_t _count;
+		// Set under the mutex by the final CountDown, waiters only return after that thread released the mutex
+		bool _done;
+		std::mutex _mutex;
+		std::condition_variable _conditionVariable;
+	public:
+		Latch(std::size_t count) : _count(count), _done(count == 0) {
+
+		}
+
+		Latch(const Latch&) = delete;
+		Latch& operator=(const Latch&) = delete;
+
+		void CountDown(std::size_t count = 1) {
+			if (_count.fetch_sub(count, std::memory_order_acq_rel) == count) {
+				lock_type lock(_mutex);
+				_done = true;
+				_conditionVariable.notify_all();
+			}
+		}
+
+		// A true result does not make it safe to destroy the latch, only a returned Wait does
+		bool TryWait() const {
+			return _count.load(std::memory_order_acquire) == 0;
+		}
+
+		// Marks the wait as blocking so a ThreadPoolCPP worker waiting on its own children can be covered by a spare
+		void Wait() {
+			lock_type lock(_mutex);
+			if (_done) {
+				return;
+			}
+			BlockingScope scope;
+			_conditionVariable.wait(lock, [this]() { return _done; });
+		}
+	};
+}
\ No newline at end of file
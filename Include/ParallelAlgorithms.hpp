@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Latch.hpp"
+
+namespace Threading {
+	namespace DetailAlgorithms {
+		// Enough blocks to balance load without splitting below the serial cutoff
+		inline std::size_t BlockCount(std::size_t size, std::size_t cutoff) {
+			std::size_t threads = std::thread::hardware_concurrency();
+			std::size_t maxBlocks = (threads ? threads : 1) * 4;
+			std::size_t blocks = cutoff ? (size + cutoff - 1) / cutoff : maxBlocks;
+			blocks = blocks > maxBlocks ? maxBlocks : blocks;
+			// Never create empty blocks, the scans read the first element of each
+			blocks = blocks > size ? size : blocks;
+			return blocks < 1 ? 1 : blocks;
+		}
+
+		// How many of the first diagonal outputs of a stable merge come from [first1, last1), the rest come from [first2, last2)
+		// Binary search along the diagonal, equal elements from the first range precede the second
+		template <class _InIterTy, class _CompareTy>
+		std::size_t MergeSplit(_InIterTy first1, _InIterTy last1, _InIterTy first2, _InIterTy last2, std::size_t diagonal, _CompareTy compare) {
+			std::size_t size1 = (std::size_t)(last1 - first1);
+			std::size_t size2 = (std::size_t)(last2 - first2);
+			std::size_t low = diagonal > size2 ? diagonal - size2 : 0;
+			std::size_t high = diagonal < size1 ? diagonal : size1;
+			while (low < high) {
+				std::size_t middle = low + (high - low) / 2;
+				if (!compare(first2[(std::ptrdiff_t)(diagonal - middle - 1)], first1[(std::ptrdiff_t)middle])) {
+					low = middle + 1;
+				} else {
+					high = middle;
+				}
+			}
+			return low;
+		}
+
+		// Output iterator that move-constructs into raw storage, the first merge round fills the sort buffer with it
+		template <class _ValueTy>
+		struct ConstructIterator {
+			using iterator_category = std::output_iterator_tag;
+			using value_type = void;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = void;
+
+			_ValueTy* position;
+
+			ConstructIterator& operator*() {
+				return *this;
+			}
+
+			template <class _OtherTy>
+			ConstructIterator& operator=(_OtherTy&& value) {
+				::new ((void*)position) _ValueTy(std::forward<_OtherTy>(value));
+				return *this;
+			}
+
+			ConstructIterator& operator++() {
+				++position;
+				return *this;
+			}
+
+			ConstructIterator operator++(int) {
+				ConstructIterator previous = *this;
+				++position;
+				return previous;
+			}
+
+			ConstructIterator operator+(std::ptrdiff_t offset) const {
+				return ConstructIterator{ position + offset };
+			}
+		};
+
+		// Uninitialized storage for the sort buffer, elements are destroyed only once a merge round constructed all of them
+		template <class _ValueTy>
+		class ScratchBuffer {
+		protected:
+			std::allocator<_ValueTy> _allocator;
+			_ValueTy* _data;
+			std::size_t _size;
+			bool _constructed;
+		public:
+			ScratchBuffer(std::size_t size) : _data(_allocator.allocate(size)), _size(size), _constructed(false) {
+
+			}
+
+			ScratchBuffer(const ScratchBuffer&) = delete;
+			ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+			~ScratchBuffer() {
+				if (_constructed) {
+					std::destroy(_data, _data + _size);
+				}
+				_allocator.deallocate(_data, _size);
+			}
+
+			_ValueTy* Data() {
+				return _data;
+			}
+
+			void Constructed() {
+				_constructed = true;
+			}
+		};
+
+		// Splits a merge of [first1, last1) and [first2, last2) into part independent merges of about the same output size (merge path)
+		template <class _PoolTy, class _InIterTy, class _OutIterTy, class _CompareTy>
+		void PushMerge(_PoolTy& threadpool, Latch& latch, std::size_t parts, _InIterTy first1, _InIterTy last1, _InIterTy first2, _InIterTy last2, _OutIterTy out, _CompareTy compare) {
+			std::size_t size = (std::size_t)((last1 - first1) + (last2 - first2));
+			_InIterTy previous1 = first1;
+			_InIterTy previous2 = first2;
+			for (std::size_t part = 1; part <= parts; ++part) {
+				_InIterTy split1 = last1;
+				_InIterTy split2 = last2;
+				if (part < parts) {
+					std::size_t diagonal = size * part / parts;
+					std::size_t taken = MergeSplit(first1, last1, first2, last2, diagonal, compare);
+					split1 = first1 + (std::ptrdiff_t)taken;
+					split2 = first2 + (std::ptrdiff_t)(diagonal - taken);
+				}
+				_OutIterTy destination = out + ((previous1 - first1) + (previous2 - first2));
+				threadpool.Push([=, &latch]() {
+					std::merge(std::make_move_iterator(previous1), std::make_move_iterator(split1), std::make_move_iterator(previous2), std::make_move_iterator(split2), destination, compare);
+					latch.CountDown();
+				});
+				previous1 = split1;
+				previous2 = split2;
+			}
+		}
+	}
+
+	constexpr std::size_t DefaultSortCutoff = 1 << 14;
+	constexpr std::size_t DefaultScanCutoff = 1 << 15;
+
+	// Calls functor(i) for every i in [first, last), chunks of grain indices run as one task
+	template <class _PoolTy, class _FuncTy>
+	void ParallelFor(_PoolTy& threadpool, std::size_t first, std::size_t last, _FuncTy functor, std::size_t grain = 1) {
+		if (first >= last) {
+			return;
+		}
+		grain = grain ? grain : 1;
+		std::size_t chunks = (last - first + grain - 1) / grain;
+		Latch latch(chunks);
+		for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+			std::size_t begin = first + chunk * grain;
+			std::size_t end = begin + grain < last ? begin + grain : last;
+			threadpool.Push([&functor, &latch, begin, end]() {
+				for (std::size_t i = begin; i < end; ++i) {
+					functor(i);
+				}
+				latch.CountDown();
+			});
+		}
+		latch.Wait();
+	}
+
+	// Parallel merge sort, blocks of at least cutoff elements are sorted with std::sort then merged pairwise
+	// Every merge round is split into as many tasks as there were blocks so the last rounds stay parallel
+	// Like std::sort the order of equal elements is unspecified and elements only need to be move constructible and assignable
+	template <class _PoolTy, class _IterTy, class _CompareTy = std::less<>>
+	void ParallelSort(_PoolTy& threadpool, _IterTy first, _IterTy last, _CompareTy compare = _CompareTy(), std::size_t cutoff = DefaultSortCutoff) {
+		using value_type = typename std::iterator_traits<_IterTy>::value_type;
+		std::size_t size = (std::size_t)(last - first);
+		std::size_t blocks = DetailAlgorithms::BlockCount(size, cutoff);
+		if (blocks < 2) {
+			std::sort(first, last, compare);
+			return;
+		}
+
+		std::vector<std::size_t> bounds(blocks + 1);
+		for (std::size_t block = 0; block <= blocks; ++block) {
+			bounds[block] = size * block / blocks;
+		}
+		ParallelFor(threadpool, 0, blocks, [&](std::size_t block) {
+			std::sort(first + (std::ptrdiff_t)bounds[block], first + (std::ptrdiff_t)bounds[block + 1], compare);
+		});
+
+		// Runs of sorted blocks double in width each round, alternating between the input and the buffer
+		// The buffer starts as raw storage, the first round covers every element and move-constructs it there
+		DetailAlgorithms::ScratchBuffer<value_type> scratch(size);
+		value_type* buffer = scratch.Data();
+		bool inBuffer = false;
+		for (std::size_t width = 1; width < blocks; width *= 2) {
+			std::size_t pairs = (blocks + 2 * width - 1) / (2 * width);
+			std::size_t parts = blocks / pairs ? blocks / pairs : 1;
+			Latch latch(pairs * parts);
+			for (std::size_t pair = 0; pair < pairs; ++pair) {
+				std::size_t begin = bounds[pair * 2 * width];
+				std::size_t middle = bounds[(std::min)(pair * 2 * width + width, blocks)];
+				std::size_t end = bounds[(std::min)(pair * 2 * width + 2 * width, blocks)];
+				if (inBuffer) {
+					DetailAlgorithms::PushMerge(threadpool, latch, parts, buffer + begin, buffer + middle, buffer + middle, buffer + end, first + (std::ptrdiff_t)begin, compare);
+				} else if (width == 1) {
+					DetailAlgorithms::PushMerge(threadpool, latch, parts, first + (std::ptrdiff_t)begin, first + (std::ptrdiff_t)middle, first + (std::ptrdiff_t)middle, first + (std::ptrdiff_t)end, DetailAlgorithms::ConstructIterator<value_type>{ buffer + begin }, compare);
+				} else {
+					DetailAlgorithms::PushMerge(threadpool, latch, parts, first + (std::ptrdiff_t)begin, first + (std::ptrdiff_t)middle, first + (std::ptrdiff_t)middle, first + (std::ptrdiff_t)end, buffer + begin, compare);
+				}
+			}
+			latch.Wait();
+			if (width == 1) {
+				scratch.Constructed();
+			}
+			inBuffer = !inBuffer;
+		}
+
+		if (inBuffer) {
+			ParallelFor(threadpool, 0, blocks, [&](std::size_t block) {
+				std::move(buffer + bounds[block], buffer + bounds[block + 1], first + (std::ptrdiff_t)bounds[block]);
+			});
+		}
+	}
+
+	// Two-pass blocked scan, op must be associative, output may alias the input
+	// Pass one reduces each block, the block totals are scanned serially, pass two rescans each block from its offset
+	template <class _PoolTy, class _InIterTy, class _OutIterTy, class _OpTy = std::plus<>>
+	_OutIterTy ParallelInclusiveScan(_PoolTy& threadpool, _InIterTy first, _InIterTy last, _OutIterTy out, _OpTy op = _OpTy(), std::size_t cutoff = DefaultScanCutoff) {
+		using value_type = typename std::iterator_traits<_InIterTy>::value_type;
+		std::size_t size = (std::size_t)(last - first);
+		std::size_t blocks = DetailAlgorithms::BlockCount(size, cutoff);
+		if (blocks < 2) {
+			return std::partial_sum(first, last, out, op);
+		}
+
+		std::vector<std::size_t> bounds(blocks + 1);
+		for (std::size_t block = 0; block <= blocks; ++block) {
+			bounds[block] = size * block / blocks;
+		}
+		// The last block's total is never needed
+		std::vector<value_type> totals(blocks - 1);
+		ParallelFor(threadpool, 0, blocks - 1, [&](std::size_t block) {
+			_InIterTy it = first + (std::ptrdiff_t)bounds[block];
+			_InIterTy end = first + (std::ptrdiff_t)bounds[block + 1];
+			value_type total = *it;
+			for (++it; it != end; ++it) {
+				total = op(total, *it);
+			}
+			totals[block] = total;
+		});
+		for (std::size_t block = 1; block < totals.size(); ++block) {
+			totals[block] = op(totals[block - 1], totals[block]);
+		}
+
+		ParallelFor(threadpool, 0, blocks, [&](std::size_t block) {
+			_InIterTy it = first + (std::ptrdiff_t)bounds[block];
+			_InIterTy end = first + (std::ptrdiff_t)bounds[block + 1];
+			_OutIterTy destination = out + (std::ptrdiff_t)bounds[block];
+			value_type running = block == 0 ? *it : op(totals[block - 1], *it);
+			*destination = running;
+			for (++it, ++destination; it != end; ++it, ++destination) {
+				running = op(running, *it);
+				*destination = running;
+			}
+		});
+		return out + (std::ptrdiff_t)size;
+	}
+
+	template <class _PoolTy, class _InIterTy, class _OutIterTy, class _ValueTy, class _OpTy = std::plus<>>
+	_OutIterTy ParallelExclusiveScan(_PoolTy& threadpool, _InIterTy first, _InIterTy last, _OutIterTy out, _ValueTy init, _OpTy op = _OpTy(), std::size_t cutoff = DefaultScanCutoff) {
+		std::size_t size = (std::size_t)(last - first);
+		std::size_t blocks = DetailAlgorithms::BlockCount(size, cutoff);
+		if (size == 0) {
+			return out;
+		}
+
+		std::vector<std::size_t> bounds(blocks + 1);
+		for (std::size_t block = 0; block <= blocks; ++block) {
+			bounds[block] = size * block / blocks;
+		}
+		std::vector<_ValueTy> offsets(blocks);
+		offsets[0] = init;
+		if (blocks > 1) {
+			// offsets[block + 1] holds the reduction of block, folded into a prefix afterwards
+			ParallelFor(threadpool, 0, blocks - 1, [&](std::size_t block) {
+				_InIterTy it = first + (std::ptrdiff_t)bounds[block];
+				_InIterTy end = first + (std::ptrdiff_t)bounds[block + 1];
+				_ValueTy total = *it;
+				for (++it; it != end; ++it) {
+					total = op(total, *it);
+				}
+				offsets[block + 1] = total;
+			});
+			for (std::size_t block = 1; block < blocks; ++block) {
+				offsets[block] = op(offsets[block - 1], offsets[block]);
+			}
+		}
+
+		// Each element is read before its output is written so the scan works in place
+		ParallelFor(threadpool, 0, blocks, [&](std::size_t block) {
+			_InIterTy it = first + (std::ptrdiff_t)bounds[block];
+			_InIterTy end = first + (std::ptrdiff_t)bounds[block + 1];
+			_OutIterTy destination = out + (std::ptrdiff_t)bounds[block];
+			_ValueTy running = offsets[block];
+			for (; it != end; ++it, ++destination) {
+				_ValueTy next = op(running, *it);
+				*destination = running;
+				running = next;
+			}
+		});
+		return out + (std::ptrdiff_t)size;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ThreadPoolCPP.hpp"
+
+namespace Threading {
+	// Dataflow pipeline in the style of TBB parallel_pipeline
+	// A serial input stage fills tokens, each token then travels through the stages on whichever worker picked it up
+	// At most maxTokens are in flight so memory stays bounded and throughput is set by the slowest stage
+	template <class _TokenTy>
+	class Pipeline {
+	public:
+		enum class Mode {
+			// Any number of tokens at once
+			Parallel,
+			// One token at a time in input order
+			SerialInOrder,
+			// One token at a time in arrival order
+			SerialOutOfOrder
+		};
+
+		using token_type = _TokenTy;
+		// Fills the token and returns true, or returns false once input is exhausted
+		using input_type = std::function<bool(token_type&)>;
+		using stage_type = std::function<void(token_type&)>;
+		using lock_type = std::unique_lock<std::mutex>;
+	protected:
+		struct Slot {
+			token_type token;
+			std::uint64_t sequence;
+		};
+
+		// Consecutive parallel stages are fused into one step, tokens only change hands at serial steps
+		struct Step {
+			Mode mode;
+			bool cheap;
+			std::vector<stage_type> stages;
+			std::mutex mutex;
+			bool busy;
+			std::uint64_t nextSequence;
+			// In-order steps index waiting tokens by sequence modulo maxTokens, out-of-order steps queue them
+			std::vector<Slot*> ordered;
+			std::deque<Slot*> arrived;
+
+			Step(Mode m, bool c) : mode(m), cheap(c), busy(false), nextSequence(0) {
+
+			}
+		};
+
+		input_type _input;
+		std::size_t _maxTokens;
+		std::vector<std::unique_ptr<Step>> _steps;
+		std::unique_ptr<Slot[]> _slots;
+		std::mutex _mutex;
+		std::condition_variable _conditionVariable;
+		std::vector<Slot*> _freeSlots;
+		bool _inputBusy;
+		bool _exhausted;
+		std::uint64_t _inputSequence;
+		std::uint64_t _tokens;
+		std::function<void(std::function<void()>)> _push;
+	public:
+		Pipeline(input_type input, std::size_t maxTokens) : _input(std::move(input)), _maxTokens(maxTokens ? maxTokens : 1), _slots(new Slot[_maxTokens]), _inputBusy(false), _exhausted(false), _inputSequence(0), _tokens(0) {
+
+		}
+
+		Pipeline(const Pipeline&) = delete;
+		Pipeline& operator=(const Pipeline&) = delete;
+
+		// A cheap serial stage drains every ready token on the thread that owns it instead of handing each to a new task
+		Pipeline& AddStage(Mode mode, stage_type stage, bool cheap = false) {
+			if (mode == Mode::Parallel && !_steps.empty() && _steps.back()->mode == Mode::Parallel) {
+				_steps.back()->stages.push_back(std::move(stage));
+				return *this;
+			}
+			_steps.emplace_back(new Step(mode, cheap));
+			_steps.back()->stages.push_back(std::move(stage));
+			_steps.back()->ordered.assign(_maxTokens, nullptr);
+			return *this;
+		}
+
+		std::size_t MaxTokens() const {
+			return _maxTokens;
+		}
+
+		// Number of steps after fusing parallel stages
+		std::size_t Steps() const {
+			return _steps.size();
+		}
+
+		// Runs the pipeline until input is exhausted and every token has left the last stage, returns the number of tokens
+		template <class _PoolTy>
+		std::uint64_t Run(_PoolTy& threadpool) {
+			{
+				lock_type lock(_mutex);
+				_freeSlots.clear();
+				for (std::size_t i = 0; i < _maxTokens; ++i) {
+					_freeSlots.push_back(&_slots[i]);
+				}
+				_inputBusy = false;
+				_exhausted = false;
+				_inputSequence = 0;
+				_tokens = 0;
+				for (auto& step : _steps) {
+					step->busy = false;
+					step->nextSequence = 0;
+					step->arrived.clear();
+					step->ordered.assign(_maxTokens, nullptr);
+				}
+				_push = [&threadpool](std::function<void()> work) { threadpool.Push(work); };
+			}
+			StartInput();
+
+			lock_type lock(_mutex);
+			if (!Finished()) {
+				BlockingScope scope;
+				_conditionVariable.wait(lock, [this]() { return Finished(); });
+			}
+			return _tokens;
+		}
+	private:
+		bool Finished() const {
+			return _exhausted && !_inputBusy && _freeSlots.size() == _maxTokens;
+		}
+
+		// Caller holds _mutex, returns the slot for the next input task or nullptr if input cannot start
+		Slot* ClaimInput() {
+			if (_inputBusy || _exhausted || _freeSlots.empty()) {
+				return nullptr;
+			}
+			_inputBusy = true;
+			Slot* slot = _freeSlots.back();
+			_freeSlots.pop_back();
+			return slot;
+		}
+
+		void StartInput() {
+			Slot* slot = nullptr;
+			{
+				lock_type lock(_mutex);
+				slot = ClaimInput();
+			}
+			if (slot != nullptr) {
+				_push([this, slot]() { Input(slot); });
+			}
+		}
+
+		void Input(Slot* slot) {
+			bool filled = _input(slot->token);
+			{
+				lock_type lock(_mutex);
+				_inputBusy = false;
+				if (!filled) {
+					_exhausted = true;
+					_freeSlots.push_back(slot);
+					if (Finished()) {
+						_conditionVariable.notify_all();
+					}
+					return;
+				}
+				slot->sequence = _inputSequence++;
+				++_tokens;
+			}
+			// Keep the input stage busy while tokens remain, this worker carries the new token downstream
+			StartInput();
+			Advance(slot, 0);
+		}
+
+		// Must be the last use of this, Run may return and the pipeline be destroyed as soon as the mutex is released
+		void Release(Slot* slot) {
+			Slot* inputSlot = nullptr;
+			{
+				lock_type lock(_mutex);
+				_freeSlots.push_back(slot);
+				if (Finished()) {
+					_conditionVariable.notify_all();
+					return;
+				}
+				// Claimed under the same lock, a busy input keeps Run waiting until the push below is done
+				inputSlot = ClaimInput();
+			}
+			if (inputSlot != nullptr) {
+				_push([this, inputSlot]() { Input(inputSlot); });
+			}
+		}
+
+		// Carries a token from step index to the end, stopping early if a serial step is owned by another thread
+		void Advance(Slot* slot, std::size_t index) {
+			for (; index < _steps.size(); ++index) {
+				Step& step = *_steps[index];
+				if (step.mode == Mode::Parallel) {
+					RunStages(step, slot);
+					continue;
+				}
+				if (!Acquire(step, slot)) {
+					return;
+				}
+				RunSerial(index, slot);
+			}
+			Release(slot);
+		}
+
+		// Takes ownership of a serial step for slot, or parks slot for the current owner
+		bool Acquire(Step& step, Slot* slot) {
+			lock_type lock(step.mutex);
+			if (!step.busy && (step.mode == Mode::SerialOutOfOrder || slot->sequence == step.nextSequence)) {
+				step.busy = true;
+				return true;
+			}
+			if (step.mode == Mode::SerialInOrder) {
+				step.ordered[slot->sequence % _maxTokens] = slot;
+			} else {
+				step.arrived.push_back(slot);
+			}
+			return false;
+		}
+
+		// Caller owns the serial step, runs it for slot then hands ownership to the next ready token
+		void RunSerial(std::size_t index, Slot* slot) {
+			Step& step = *_steps[index];
+			RunStages(step, slot);
+			for (;;) {
+				Slot* next = nullptr;
+				{
+					lock_type lock(step.mutex);
+					++step.nextSequence;
+					next = NextReady(step);
+					if (next == nullptr) {
+						step.busy = false;
+						return;
+					}
+				}
+				if (!step.cheap) {
+					// The owner keeps the step, a new task runs it for the next token while slot continues here
+					_push([this, index, next]() { RunSerial(index, next); Advance(next, index + 1); });
+					return;
+				}
+				RunStages(step, next);
+				_push([this, index, next]() { Advance(next, index + 1); });
+			}
+		}
+
+		Slot* NextReady(Step& step) {
+			if (step.mode == Mode::SerialInOrder) {
+				Slot*& waiting = step.ordered[step.nextSequence % _maxTokens];
+				if (waiting != nullptr && waiting->sequence == step.nextSequence) {
+					Slot* next = waiting;
+					waiting = nullptr;
+					return next;
+				}
+				return nullptr;
+			}
+			if (step.arrived.empty()) {
+				return nullptr;
+			}
+			Slot* next = step.arrived.front();
+			step.arrived.pop_front();
+			return next;
+		}
+
+		static void RunStages(Step& step, Slot* slot) {
+			for (stage_type& stage : step.stages) {
+				stage(slot->token);
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "ThreadPoolCPP.hpp"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace Threading {
+	using PartitionId = std::size_t;
+
+	struct PartitionSettings {
+		// Cores the child owns, it always keeps at least one of them
+		std::size_t guaranteedCores = 1;
+		// Most cores the child takes from idle siblings and unassigned cores on top of its own
+		std::size_t borrowableCores = 0;
+		// Lends idle owned cores to siblings, they come back as soon as the child has queued work
+		bool lendIdle = true;
+		ThreadPoolCPPSettings threadpool;
+	};
+
+	struct PartitionMetrics {
+		std::vector<int> ownedCores;
+		std::size_t activeThreads;
+		std::size_t lentCores;
+		std::size_t borrowedCores;
+		// Cores this child borrowed and cores its owners took back over the partition's lifetime
+		std::uint64_t loans;
+		std::uint64_t reclaims;
+	};
+
+	// Splits a set of processors between child threadpools, each pinned to the cores it holds
+	// Every child owns guaranteedCores and has one worker per core it may hold, workers beyond the cores it holds stay parked
+	// A controller lends the owned cores of children without queued work to siblings that have some, one core per child per period
+	// An owner with queued work gets its cores back on the next period, the borrower's worker is parked and moved off the core even mid-task
+	class PoolPartition {
+	public:
+		using lock_type = std::unique_lock<std::mutex>;
+
+		static constexpr std::chrono::microseconds DefaultPeriod = std::chrono::microseconds(1000);
+	protected:
+		struct Child {
+			std::unique_ptr<ThreadPoolCPP> threadpool;
+			PartitionSettings settings;
+			std::vector<int> owned;
+			// Owned cores not lent out, worker i runs on home[i] and the workers after them on borrowed cores
+			std::vector<int> home;
+			std::uint64_t loans;
+			std::uint64_t reclaims;
+		};
+
+		// Lender is the borrowing child's own index for unassigned cores, which are never reclaimed
+		struct Loan {
+			PartitionId lender;
+			PartitionId borrower;
+			int cpu;
+			bool unassigned;
+		};
+
+		std::vector<int> _cpus;
+		std::vector<int> _unassigned;
+		std::chrono::microseconds _period;
+		bool _run;
+		std::mutex _mutex;
+		std::condition_variable _conditionVariable;
+		std::vector<std::unique_ptr<Child>> _children;
+		std::vector<Loan> _loans;
+		std::thread _thread;
+	public:
+		// Uses the processors the process may run on, period bounds how long an owner waits for a lent core
+		PoolPartition(std::vector<int> cpus = AvailableCpus(), std::chrono::microseconds period = DefaultPeriod) : _cpus(cpus), _unassigned(cpus), _period(period.count() > 0 ? period : DefaultPeriod), _run(true) {
+			_thread = std::thread(&PoolPartition::Controller, this);
+		}
+
+		PoolPartition(const PoolPartition&) = delete;
+		PoolPartition& operator=(const PoolPartition&) = delete;
+
+		// Stops the controller, then the children are destroyed like any ThreadPoolCPP
+		~PoolPartition() {
+			{
+				lock_type lock(_mutex);
+				_run = false;
+			}
+			_conditionVariable.notify_all();
+			_thread.join();
+		}
+
+		// Takes guaranteedCores from the unassigned cores, throws std::invalid_argument when too few are left
+		// Unassigned cores lent to children count as left, they are taken back first
+		PartitionId AddPool(PartitionSettings settings) {
+			lock_type lock(_mutex);
+			settings.guaranteedCores = settings.guaranteedCores ? settings.guaranteedCores : 1;
+			if (settings.guaranteedCores > _unassigned.size() + UnassignedLoans()) {
+				throw std::invalid_argument("PoolPartition: not enough unassigned cores");
+			}
+			while (settings.guaranteedCores > _unassigned.size()) {
+				Return(LastUnassignedLoan());
+			}
+			std::unique_ptr<Child> child(new Child{ nullptr, settings, {}, {}, 0, 0 });
+			child->owned.assign(_unassigned.begin(), _unassigned.begin() + settings.guaranteedCores);
+			_unassigned.erase(_unassigned.begin(), _unassigned.begin() + settings.guaranteedCores);
+			child->home = child->owned;
+			child->threadpool.reset(new ThreadPoolCPP(settings.guaranteedCores + settings.borrowableCores, settings.threadpool));
+			_children.push_back(std::move(child));
+			PartitionId id = _children.size() - 1;
+			Apply(id);
+			return id;
+		}
+
+		// Throws std::out_of_range for an id AddPool did not return
+		ThreadPoolCPP& Pool(PartitionId id) {
+			lock_type lock(_mutex);
+			return *Find(id).threadpool;
+		}
+
+		std::size_t Pools() {
+			lock_type lock(_mutex);
+			return _children.size();
+		}
+
+		const std::vector<int>& Cpus() const {
+			return _cpus;
+		}
+
+		// Throws std::out_of_range for an id AddPool did not return
+		PartitionMetrics GetMetrics(PartitionId id) {
+			lock_type lock(_mutex);
+			Child& child = Find(id);
+			return PartitionMetrics{ child.owned, child.threadpool->ActiveThreads(), child.owned.size() - child.home.size(), Borrowed(id), child.loans, child.reclaims };
+		}
+
+		// Processors the calling process may run on, 0 to hardware_concurrency - 1 where that cannot be queried
+		static std::vector<int> AvailableCpus() {
+			std::vector<int> cpus;
+#if defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+				for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+					if (CPU_ISSET(cpu, &set)) {
+						cpus.push_back(cpu);
+					}
+				}
+			}
+#endif
+			if (cpus.empty()) {
+				unsigned int count = std::thread::hardware_concurrency();
+				for (unsigned int cpu = 0; cpu < (count ? count : 1); ++cpu) {
+					cpus.push_back((int)cpu);
+				}
+			}
+			return cpus;
+		}
+	private:
+		Child& Find(PartitionId id) {
+			if (id >= _children.size()) {
+				throw std::out_of_range("PoolPartition: unknown pool");
+			}
+			return *_children[id];
+		}
+
+		void Controller() {
+			lock_type lock(_mutex);
+			while (_run) {
+				_conditionVariable.wait_for(lock, _period, [this]() { return !_run; });
+				if (!_run) {
+					break;
+				}
+				std::vector<std::size_t> queued(_children.size());
+				std::vector<std::size_t> busy(_children.size());
+				for (PartitionId id = 0; id < _children.size(); ++id) {
+					queued[id] = _children[id]->threadpool->QueuedTasks();
+					busy[id] = _children[id]->threadpool->BusyThreads();
+				}
+				// Owners with queued work take back everything they lent, up to what they have queued
+				for (PartitionId id = 0; id < _children.size(); ++id) {
+					for (std::size_t taken = 0; taken < queued[id]; ++taken) {
+						std::size_t loan = LastLoan(id);
+						if (loan == _loans.size()) {
+							break;
+						}
+						_children[id]->reclaims += 1;
+						Return(loan);
+					}
+				}
+				for (PartitionId id = 0; id < _children.size(); ++id) {
+					Child& child = *_children[id];
+					std::size_t borrowed = Borrowed(id);
+					if (queued[id] == 0 && borrowed != 0 && busy[id] < child.threadpool->ActiveThreads()) {
+						// Nothing queued and a worker idle, give one core back
+						Return(LastBorrowed(id));
+					} else if (queued[id] != 0 && borrowed < child.settings.borrowableCores) {
+						Borrow(id, queued, busy);
+					}
+				}
+			}
+		}
+
+		// Unassigned cores first, then an owned core of a sibling with nothing queued and an idle worker
+		void Borrow(PartitionId borrower, const std::vector<std::size_t>& queued, const std::vector<std::size_t>& busy) {
+			if (!_unassigned.empty()) {
+				_loans.push_back(Loan{ borrower, borrower, _unassigned.back(), true });
+				_unassigned.pop_back();
+			} else {
+				PartitionId lender = 0;
+				for (; lender < _children.size(); ++lender) {
+					Child& child = *_children[lender];
+					if (lender != borrower && child.settings.lendIdle && queued[lender] == 0 && child.home.size() > 1 && busy[lender] < child.threadpool->ActiveThreads()) {
+						break;
+					}
+				}
+				if (lender == _children.size()) {
+					return;
+				}
+				Child& child = *_children[lender];
+				_loans.push_back(Loan{ lender, borrower, child.home.back(), false });
+				child.home.pop_back();
+				Apply(lender);
+			}
+			_children[borrower]->loans += 1;
+			Apply(borrower);
+		}
+
+		void Return(std::size_t index) {
+			Loan loan = _loans[index];
+			_loans.erase(_loans.begin() + index);
+			// The borrower's worker leaves the core before the owner's worker is given it
+			Apply(loan.borrower);
+			if (loan.unassigned) {
+				_unassigned.push_back(loan.cpu);
+			} else {
+				_children[loan.lender]->home.push_back(loan.cpu);
+				Apply(loan.lender);
+			}
+		}
+
+		// Most recent loan out of lender's owned cores, _loans.size() when it has none out
+		std::size_t LastLoan(PartitionId lender) const {
+			for (std::size_t index = _loans.size(); index-- > 0;) {
+				if (!_loans[index].unassigned && _loans[index].lender == lender) {
+					return index;
+				}
+			}
+			return _loans.size();
+		}
+
+		std::size_t LastUnassignedLoan() const {
+			for (std::size_t index = _loans.size(); index-- > 0;) {
+				if (_loans[index].unassigned) {
+					return index;
+				}
+			}
+			return _loans.size();
+		}
+
+		std::size_t UnassignedLoans() const {
+			std::size_t count = 0;
+			for (const Loan& loan : _loans) {
+				count += loan.unassigned ? 1 : 0;
+			}
+			return count;
+		}
+
+		std::size_t LastBorrowed(PartitionId borrower) const {
+			for (std::size_t index = _loans.size(); index-- > 0;) {
+				if (_loans[index].borrower == borrower) {
+					return index;
+				}
+			}
+			return _loans.size();
+		}
+
+		std::size_t Borrowed(PartitionId borrower) const {
+			std::size_t count = 0;
+			for (const Loan& loan : _loans) {
+				count += loan.borrower == borrower ? 1 : 0;
+			}
+			return count;
+		}
+
+		// Pins the child's workers to the cores it holds and lets exactly that many take work
+		// Parked workers move to the first owned core, one still running a task must not keep a core that went back to its owner
+		void Apply(PartitionId id) {
+			Child& child = *_children[id];
+			std::size_t worker = 0;
+			for (int cpu : child.home) {
+				child.threadpool->SetWorkerAffinity(worker++, cpu);
+			}
+			for (const Loan& loan : _loans) {
+				if (loan.borrower == id) {
+					child.threadpool->SetWorkerAffinity(worker++, loan.cpu);
+				}
+			}
+			child.threadpool->SetActiveThreads(worker);
+			for (std::size_t parked = worker; parked < child.threadpool->Size(); ++parked) {
+				child.threadpool->SetWorkerAffinity(parked, child.home.front());
+			}
+		}
+	};
+}
\ No newline at end of file
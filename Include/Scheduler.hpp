@@ -0,0 +1,455 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Latch.hpp"
+#include "ParallelAlgorithms.hpp"
+
+namespace Threading {
+	// Sender/receiver adapter shaped after P2300 (std::execution) for any threadpool with Push(functor)
+	// Senders have connect(receiver), operation states have start(), receivers have set_value(values...), set_error(std::exception_ptr) and set_stopped()
+	// Operation states cannot move and live where they were connected, inside SyncWait's frame or the enclosing operation
+	// A scheduled task pushes a closure holding only the operation's address, std::function keeps it inline so nothing is allocated per task
+	// Work dropped by a threadpool shutdown never completes its receiver
+	template <class _PoolTy>
+	class PoolScheduler;
+
+	namespace DetailScheduler {
+		template <class..._TuplesTy>
+		struct Single;
+
+		// Senders here complete with one value signature, value_types<std::tuple, SingleType> names it
+		template <class _TupleTy>
+		struct Single<_TupleTy> {
+			using type = _TupleTy;
+		};
+
+		template <class..._TuplesTy>
+		using SingleType = typename Single<_TuplesTy...>::type;
+
+		template <class _SenderTy>
+		using ValueTuple = typename std::decay_t<_SenderTy>::template value_types<std::tuple, SingleType>;
+
+		template <class _FuncTy, class _TupleTy>
+		struct ApplyResult;
+
+		template <class _FuncTy, class..._ValuesTy>
+		struct ApplyResult<_FuncTy, std::tuple<_ValuesTy...>> {
+			using type = std::invoke_result_t<_FuncTy, _ValuesTy...>;
+		};
+
+		template <class _ResultTy>
+		struct ResultTuple {
+			using type = std::tuple<_ResultTy>;
+		};
+
+		template <>
+		struct ResultTuple<void> {
+			using type = std::tuple<>;
+		};
+
+		template <template <class...> class _TupleTy, class _ValuesTy>
+		struct Rebind;
+
+		template <template <class...> class _TupleTy, class..._ValuesTy>
+		struct Rebind<_TupleTy, std::tuple<_ValuesTy...>> {
+			using type = _TupleTy<_ValuesTy...>;
+		};
+
+		template <class _ValuesTy>
+		struct SyncWaitState {
+			Latch latch;
+			std::optional<_ValuesTy> values;
+			std::exception_ptr error;
+
+			SyncWaitState() : latch(1) {
+
+			}
+		};
+
+		template <class _ValuesTy>
+		struct SyncWaitReceiver {
+			SyncWaitState<_ValuesTy>* state;
+
+			template <class..._ArgsTy>
+			void set_value(_ArgsTy&&...values) {
+				state->values.emplace(std::forward<_ArgsTy>(values)...);
+				state->latch.CountDown();
+			}
+
+			void set_error(std::exception_ptr error) noexcept {
+				state->error = std::move(error);
+				state->latch.CountDown();
+			}
+
+			void set_stopped() noexcept {
+				state->latch.CountDown();
+			}
+		};
+
+		// All chunks in one PushBatch, one queue lock and one wake-up round for the whole bulk
+		// pushed counts the chunks queued, also when a push throws, so the caller knows how many will still run
+		template <class _PoolTy, class _OperationTy>
+		auto PushChunks(_PoolTy& threadpool, _OperationTy* operation, std::size_t chunks, std::size_t& pushed, int) -> decltype(threadpool.PushBatch(std::declval<std::vector<typename _PoolTy::work_type>&>()), void()) {
+			std::vector<typename _PoolTy::work_type> works;
+			works.reserve(chunks);
+			for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+				works.emplace_back([operation, chunk]() { operation->RunChunk(chunk); });
+			}
+			try {
+				threadpool.PushBatch(works);
+			} catch (...) {
+				// PushBatch leaves the tasks it did not queue in works
+				pushed = chunks - works.size();
+				throw;
+			}
+			pushed = chunks;
+		}
+
+		// Backends without PushBatch take the chunks one Push at a time
+		template <class _PoolTy, class _OperationTy>
+		void PushChunks(_PoolTy& threadpool, _OperationTy* operation, std::size_t chunks, std::size_t& pushed, long) {
+			for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+				threadpool.Push([operation, chunk]() { operation->RunChunk(chunk); });
+				++pushed;
+			}
+		}
+	}
+
+	template <class _PoolTy, class _ReceiverTy>
+	class ScheduleOperation {
+	protected:
+		_PoolTy* _threadpool;
+		_ReceiverTy _receiver;
+	public:
+		ScheduleOperation(_PoolTy& threadpool, _ReceiverTy receiver) : _threadpool(&threadpool), _receiver(std::move(receiver)) {
+
+		}
+
+		ScheduleOperation(const ScheduleOperation&) = delete;
+		ScheduleOperation& operator=(const ScheduleOperation&) = delete;
+
+		void start() noexcept {
+			try {
+				_threadpool->Push([this]() { Run(); });
+			} catch (...) {
+				_receiver.set_error(std::current_exception());
+			}
+		}
+	private:
+		void Run() {
+			try {
+				_receiver.set_value();
+			} catch (...) {
+				_receiver.set_error(std::current_exception());
+			}
+		}
+	};
+
+	// Completes with no values on a worker of the threadpool
+	template <class _PoolTy>
+	class ScheduleSender {
+	protected:
+		_PoolTy* _threadpool;
+	public:
+		template <template <class...> class _TupleTy, template <class...> class _VariantTy>
+		using value_types = _VariantTy<_TupleTy<>>;
+		template <template <class...> class _VariantTy>
+		using error_types = _VariantTy<std::exception_ptr>;
+		static constexpr bool sends_stopped = false;
+
+		explicit ScheduleSender(_PoolTy& threadpool) : _threadpool(&threadpool) {
+
+		}
+
+		template <class _ReceiverTy>
+		ScheduleOperation<_PoolTy, std::decay_t<_ReceiverTy>> connect(_ReceiverTy&& receiver) const {
+			return ScheduleOperation<_PoolTy, std::decay_t<_ReceiverTy>>(*_threadpool, std::forward<_ReceiverTy>(receiver));
+		}
+
+		PoolScheduler<_PoolTy> get_completion_scheduler() const {
+			return PoolScheduler<_PoolTy>(*_threadpool);
+		}
+	};
+
+	template <class _SenderTy, class _FuncTy, class _ReceiverTy>
+	class ThenOperation {
+	public:
+		struct inner_receiver {
+			ThenOperation* operation;
+
+			template <class..._ValuesTy>
+			void set_value(_ValuesTy&&...values) {
+				operation->Complete(std::forward<_ValuesTy>(values)...);
+			}
+
+			void set_error(std::exception_ptr error) noexcept {
+				operation->_receiver.set_error(std::move(error));
+			}
+
+			void set_stopped() noexcept {
+				operation->_receiver.set_stopped();
+			}
+		};
+	protected:
+		_FuncTy _functor;
+		_ReceiverTy _receiver;
+		decltype(std::declval<_SenderTy>().connect(std::declval<inner_receiver>())) _operation;
+	public:
+		ThenOperation(_SenderTy sender, _FuncTy functor, _ReceiverTy receiver) : _functor(std::move(functor)), _receiver(std::move(receiver)), _operation(std::move(sender).connect(inner_receiver{ this })) {
+
+		}
+
+		ThenOperation(const ThenOperation&) = delete;
+		ThenOperation& operator=(const ThenOperation&) = delete;
+
+		void start() noexcept {
+			_operation.start();
+		}
+	private:
+		template <class..._ValuesTy>
+		void Complete(_ValuesTy&&...values) {
+			try {
+				if constexpr (std::is_void_v<std::invoke_result_t<_FuncTy&, _ValuesTy...>>) {
+					_functor(std::forward<_ValuesTy>(values)...);
+					_receiver.set_value();
+				} else {
+					_receiver.set_value(_functor(std::forward<_ValuesTy>(values)...));
+				}
+			} catch (...) {
+				_receiver.set_error(std::current_exception());
+			}
+		}
+	};
+
+	// Calls functor with the values of sender on the thread that produced them and sends its result
+	template <class _SenderTy, class _FuncTy>
+	class ThenSender {
+	protected:
+		_SenderTy _sender;
+		_FuncTy _functor;
+	public:
+		using result_tuple = typename DetailScheduler::ResultTuple<typename DetailScheduler::ApplyResult<_FuncTy&, DetailScheduler::ValueTuple<_SenderTy>>::type>::type;
+
+		template <template <class...> class _TupleTy, template <class...> class _VariantTy>
+		using value_types = _VariantTy<typename DetailScheduler::Rebind<_TupleTy, result_tuple>::type>;
+		template <template <class...> class _VariantTy>
+		using error_types = _VariantTy<std::exception_ptr>;
+		static constexpr bool sends_stopped = _SenderTy::sends_stopped;
+
+		ThenSender(_SenderTy sender, _FuncTy functor) : _sender(std::move(sender)), _functor(std::move(functor)) {
+
+		}
+
+		template <class _ReceiverTy>
+		ThenOperation<_SenderTy, _FuncTy, std::decay_t<_ReceiverTy>> connect(_ReceiverTy&& receiver) const {
+			return ThenOperation<_SenderTy, _FuncTy, std::decay_t<_ReceiverTy>>(_sender, _functor, std::forward<_ReceiverTy>(receiver));
+		}
+
+		auto get_completion_scheduler() const {
+			return _sender.get_completion_scheduler();
+		}
+	};
+
+	template <class _PoolTy, class _SenderTy, class _FuncTy, class _ReceiverTy>
+	class BulkOperation {
+	public:
+		using value_tuple = DetailScheduler::ValueTuple<_SenderTy>;
+
+		struct inner_receiver {
+			BulkOperation* operation;
+
+			template <class..._ValuesTy>
+			void set_value(_ValuesTy&&...values) {
+				operation->Split(std::forward<_ValuesTy>(values)...);
+			}
+
+			void set_error(std::exception_ptr error) noexcept {
+				operation->_receiver.set_error(std::move(error));
+			}
+
+			void set_stopped() noexcept {
+				operation->_receiver.set_stopped();
+			}
+		};
+	protected:
+		_PoolTy* _threadpool;
+		std::size_t _shape;
+		std::size_t _chunks;
+		_FuncTy _functor;
+		_ReceiverTy _receiver;
+		std::optional<value_tuple> _values;
+		std::atomic_size_t _remaining;
+		// First exception thrown by functor or by pushing the chunks, written by whoever sets _failed
+		std::atomic_bool _failed;
+		std::exception_ptr _error;
+		decltype(std::declval<_SenderTy>().connect(std::declval<inner_receiver>())) _operation;
+	public:
+		BulkOperation(_PoolTy& threadpool, _SenderTy sender, std::size_t shape, _FuncTy functor, _ReceiverTy receiver) : _threadpool(&threadpool), _shape(shape), _chunks(0), _functor(std::move(functor)), _receiver(std::move(receiver)), _remaining(0), _failed(false), _operation(std::move(sender).connect(inner_receiver{ this })) {
+
+		}
+
+		BulkOperation(const BulkOperation&) = delete;
+		BulkOperation& operator=(const BulkOperation&) = delete;
+
+		void start() noexcept {
+			_operation.start();
+		}
+
+		// Body of the pushed chunk tasks
+		void RunChunk(std::size_t chunk) {
+			std::size_t first = _shape * chunk / _chunks;
+			std::size_t last = _shape * (chunk + 1) / _chunks;
+			try {
+				for (std::size_t i = first; i < last; ++i) {
+					std::apply([this, i](auto&...values) { _functor(i, values...); }, *_values);
+				}
+			} catch (...) {
+				if (!_failed.exchange(true, std::memory_order_acq_rel)) {
+					_error = std::current_exception();
+				}
+			}
+			if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				Finish();
+			}
+		}
+	private:
+		template <class..._ValuesTy>
+		void Split(_ValuesTy&&...values) {
+			_values.emplace(std::forward<_ValuesTy>(values)...);
+			if (_shape == 0) {
+				Finish();
+				return;
+			}
+			// Same chunking as ParallelFor without a grain, a few chunks per hardware thread
+			_chunks = DetailAlgorithms::BlockCount(_shape, 0);
+			// Split holds one count of its own so no chunk can finish the operation while chunks are still being pushed
+			_remaining.store(_chunks + 1, std::memory_order_relaxed);
+			std::size_t pushed = 0;
+			try {
+				DetailScheduler::PushChunks(*_threadpool, this, _chunks, pushed, 0);
+			} catch (...) {
+				// Chunks already pushed still run, whoever counts down last completes the receiver with the error
+				if (!_failed.exchange(true, std::memory_order_acq_rel)) {
+					_error = std::current_exception();
+				}
+			}
+			std::size_t released = _chunks - pushed + 1;
+			if (_remaining.fetch_sub(released, std::memory_order_acq_rel) == released) {
+				Finish();
+			}
+		}
+
+		void Finish() {
+			if (_failed.load(std::memory_order_acquire)) {
+				_receiver.set_error(_error);
+				return;
+			}
+			try {
+				std::apply([this](auto&...values) { _receiver.set_value(std::move(values)...); }, *_values);
+			} catch (...) {
+				_receiver.set_error(std::current_exception());
+			}
+		}
+	};
+
+	// Calls functor(i, values...) for i in [0, shape) as chunked tasks on the threadpool, then sends the values on
+	template <class _PoolTy, class _SenderTy, class _FuncTy>
+	class BulkSender {
+	protected:
+		_PoolTy* _threadpool;
+		_SenderTy _sender;
+		std::size_t _shape;
+		_FuncTy _functor;
+	public:
+		template <template <class...> class _TupleTy, template <class...> class _VariantTy>
+		using value_types = typename _SenderTy::template value_types<_TupleTy, _VariantTy>;
+		template <template <class...> class _VariantTy>
+		using error_types = _VariantTy<std::exception_ptr>;
+		static constexpr bool sends_stopped = _SenderTy::sends_stopped;
+
+		BulkSender(_PoolTy& threadpool, _SenderTy sender, std::size_t shape, _FuncTy functor) : _threadpool(&threadpool), _sender(std::move(sender)), _shape(shape), _functor(std::move(functor)) {
+
+		}
+
+		template <class _ReceiverTy>
+		BulkOperation<_PoolTy, _SenderTy, _FuncTy, std::decay_t<_ReceiverTy>> connect(_ReceiverTy&& receiver) const {
+			return BulkOperation<_PoolTy, _SenderTy, _FuncTy, std::decay_t<_ReceiverTy>>(*_threadpool, _sender, _shape, _functor, std::forward<_ReceiverTy>(receiver));
+		}
+
+		PoolScheduler<_PoolTy> get_completion_scheduler() const {
+			return PoolScheduler<_PoolTy>(*_threadpool);
+		}
+	};
+
+	// Lightweight handle, copies compare equal when they refer to the same threadpool
+	template <class _PoolTy>
+	class PoolScheduler {
+	protected:
+		_PoolTy* _threadpool;
+	public:
+		explicit PoolScheduler(_PoolTy& threadpool) : _threadpool(&threadpool) {
+
+		}
+
+		ScheduleSender<_PoolTy> schedule() const {
+			return ScheduleSender<_PoolTy>(*_threadpool);
+		}
+
+		// The scheduler's bulk customization, sender may complete anywhere, the chunks run on this threadpool
+		template <class _SenderTy, class _FuncTy>
+		BulkSender<_PoolTy, std::decay_t<_SenderTy>, std::decay_t<_FuncTy>> bulk(_SenderTy&& sender, std::size_t shape, _FuncTy&& functor) const {
+			return BulkSender<_PoolTy, std::decay_t<_SenderTy>, std::decay_t<_FuncTy>>(*_threadpool, std::forward<_SenderTy>(sender), shape, std::forward<_FuncTy>(functor));
+		}
+
+		_PoolTy& Pool() const {
+			return *_threadpool;
+		}
+
+		bool operator==(const PoolScheduler& other) const {
+			return _threadpool == other._threadpool;
+		}
+
+		bool operator!=(const PoolScheduler& other) const {
+			return _threadpool != other._threadpool;
+		}
+	};
+
+	template <class _PoolTy>
+	PoolScheduler<_PoolTy> MakeScheduler(_PoolTy& threadpool) {
+		return PoolScheduler<_PoolTy>(threadpool);
+	}
+
+	template <class _SenderTy, class _FuncTy>
+	ThenSender<std::decay_t<_SenderTy>, std::decay_t<_FuncTy>> Then(_SenderTy&& sender, _FuncTy&& functor) {
+		return ThenSender<std::decay_t<_SenderTy>, std::decay_t<_FuncTy>>(std::forward<_SenderTy>(sender), std::forward<_FuncTy>(functor));
+	}
+
+	// Bulk on the threadpool sender completes on, senders from this header all know theirs
+	template <class _SenderTy, class _FuncTy>
+	auto Bulk(_SenderTy&& sender, std::size_t shape, _FuncTy&& functor) {
+		auto scheduler = sender.get_completion_scheduler();
+		return scheduler.bulk(std::forward<_SenderTy>(sender), shape, std::forward<_FuncTy>(functor));
+	}
+
+	// Starts sender and blocks until it completes, the operation state lives in this frame
+	// Returns the values, nullopt when the sender was stopped, and rethrows its error
+	template <class _SenderTy>
+	std::optional<DetailScheduler::ValueTuple<_SenderTy>> SyncWait(_SenderTy&& sender) {
+		using value_tuple = DetailScheduler::ValueTuple<_SenderTy>;
+		DetailScheduler::SyncWaitState<value_tuple> state;
+		auto operation = std::forward<_SenderTy>(sender).connect(DetailScheduler::SyncWaitReceiver<value_tuple>{ &state });
+		operation.start();
+		state.latch.Wait();
+		if (state.error) {
+			std::rethrow_exception(state.error);
+		}
+		return std::move(state.values);
+	}
+}
\ No newline at end of file
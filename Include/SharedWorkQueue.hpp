@@ -0,0 +1,366 @@
+#pragma once
+
+#if !defined(_WIN32)
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ThreadPoolCPP.hpp"
+
+namespace Threading {
+	using HandlerId = std::uint32_t;
+
+	// Bounded lock-free MPMC ring in a POSIX shared-memory segment, every process that maps it can push and pop
+	// Tasks are a handler id and a POD payload copied into the slot, handlers are looked up in the consuming process
+	// A process that dies between claiming a slot and publishing it stalls the ring at that slot
+	class SharedWorkQueue {
+	public:
+		static constexpr std::uint64_t Magic = 0x5450435055455545ull;
+	protected:
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared memory needs address-free atomics");
+
+		struct Header {
+			std::atomic_uint64_t magic;
+			std::uint64_t capacity;
+			std::uint64_t payloadSize;
+			std::uint64_t slotStride;
+			alignas(64) std::atomic_uint64_t enqueue;
+			alignas(64) std::atomic_uint64_t dequeue;
+		};
+
+		// Sequence follows the ring position, it equals the position while free and position + 1 while full
+		struct Slot {
+			std::atomic_uint64_t sequence;
+			HandlerId handler;
+			std::uint32_t size;
+		};
+
+		std::string _name;
+		void* _memory;
+		std::size_t _length;
+		Header* _header;
+	public:
+		// Creates the segment, fails if it exists, capacity is rounded up to a power of two
+		static SharedWorkQueue Create(const std::string& name, std::size_t capacity, std::size_t payloadSize) {
+			std::size_t rounded = 1;
+			while (rounded < capacity) {
+				rounded <<= 1;
+			}
+			std::size_t stride = (sizeof(Slot) + payloadSize + 63) / 64 * 64;
+			std::size_t length = HeaderSize() + rounded * stride;
+			int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd < 0) {
+				throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+			}
+			if (ftruncate(fd, (off_t)length) != 0) {
+				int error = errno;
+				close(fd);
+				shm_unlink(name.c_str());
+				throw std::system_error(error, std::generic_category(), "ftruncate " + name);
+			}
+			SharedWorkQueue queue(name, fd, length);
+			Header* header = queue._header;
+			new (&header->enqueue) std::atomic_uint64_t(0);
+			new (&header->dequeue) std::atomic_uint64_t(0);
+			header->capacity = rounded;
+			header->payloadSize = payloadSize;
+			header->slotStride = stride;
+			for (std::size_t i = 0; i < rounded; ++i) {
+				new (&queue.SlotAt(i)->sequence) std::atomic_uint64_t(i);
+			}
+			// Openers check the magic last, so they never see a half-built ring
+			new (&header->magic) std::atomic_uint64_t(0);
+			header->magic.store(Magic, std::memory_order_release);
+			return queue;
+		}
+
+		// Maps a segment another process created
+		static SharedWorkQueue Open(const std::string& name) {
+			int fd = shm_open(name.c_str(), O_RDWR, 0600);
+			if (fd < 0) {
+				throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+			}
+			struct stat status;
+			if (fstat(fd, &status) != 0 || (std::size_t)status.st_size < HeaderSize()) {
+				close(fd);
+				throw std::system_error(EINVAL, std::generic_category(), "SharedWorkQueue " + name);
+			}
+			SharedWorkQueue queue(name, fd, (std::size_t)status.st_size);
+			if (queue._header->magic.load(std::memory_order_acquire) != Magic) {
+				throw std::system_error(EINVAL, std::generic_category(), "SharedWorkQueue " + name);
+			}
+			return queue;
+		}
+
+		// Removes the name, mappings stay valid until every process has closed them
+		static bool Unlink(const std::string& name) {
+			return shm_unlink(name.c_str()) == 0;
+		}
+
+		SharedWorkQueue(SharedWorkQueue&& other) noexcept : _name(std::move(other._name)), _memory(other._memory), _length(other._length), _header(other._header) {
+			other._memory = nullptr;
+			other._header = nullptr;
+		}
+
+		SharedWorkQueue(const SharedWorkQueue&) = delete;
+		SharedWorkQueue& operator=(const SharedWorkQueue&) = delete;
+
+		~SharedWorkQueue() {
+			if (_memory != nullptr) {
+				munmap(_memory, _length);
+			}
+		}
+
+		// Returns false if the ring is full or the payload is larger than the slots
+		bool Push(HandlerId handler, const void* payload, std::size_t size) {
+			if (size > _header->payloadSize) {
+				return false;
+			}
+			std::uint64_t position = _header->enqueue.load(std::memory_order_relaxed);
+			Slot* slot;
+			for (;;) {
+				slot = SlotAt(position);
+				std::uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+				if (sequence == position) {
+					if (_header->enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (sequence < position) {
+					return false;
+				} else {
+					position = _header->enqueue.load(std::memory_order_relaxed);
+				}
+			}
+			slot->handler = handler;
+			slot->size = (std::uint32_t)size;
+			std::memcpy(Payload(slot), payload, size);
+			slot->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		template <class _ValueTy>
+		bool Push(HandlerId handler, const _ValueTy& payload) {
+			static_assert(std::is_trivially_copyable<_ValueTy>::value, "payloads are copied between processes");
+			return Push(handler, &payload, sizeof(payload));
+		}
+
+		// Copies the payload into payload, which must hold PayloadSize() bytes, returns false if the ring is empty
+		bool Pop(HandlerId& handler, void* payload, std::size_t& size) {
+			std::uint64_t position = _header->dequeue.load(std::memory_order_relaxed);
+			Slot* slot;
+			for (;;) {
+				slot = SlotAt(position);
+				std::uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+				if (sequence == position + 1) {
+					if (_header->dequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (sequence < position + 1) {
+					return false;
+				} else {
+					position = _header->dequeue.load(std::memory_order_relaxed);
+				}
+			}
+			handler = slot->handler;
+			size = slot->size;
+			std::memcpy(payload, Payload(slot), size);
+			slot->sequence.store(position + _header->capacity, std::memory_order_release);
+			return true;
+		}
+
+		// Approximate, other processes move both ends concurrently
+		std::size_t Size() const {
+			std::uint64_t enqueue = _header->enqueue.load(std::memory_order_relaxed);
+			std::uint64_t dequeue = _header->dequeue.load(std::memory_order_relaxed);
+			return enqueue > dequeue ? (std::size_t)(enqueue - dequeue) : 0;
+		}
+
+		std::size_t Capacity() const {
+			return (std::size_t)_header->capacity;
+		}
+
+		std::size_t PayloadSize() const {
+			return (std::size_t)_header->payloadSize;
+		}
+
+		const std::string& Name() const {
+			return _name;
+		}
+	private:
+		SharedWorkQueue(const std::string& name, int fd, std::size_t length) : _name(name), _memory(nullptr), _length(length), _header(nullptr) {
+			void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			int error = errno;
+			close(fd);
+			if (memory == MAP_FAILED) {
+				throw std::system_error(error, std::generic_category(), "mmap " + name);
+			}
+			_memory = memory;
+			_header = static_cast<Header*>(memory);
+		}
+
+		static std::size_t HeaderSize() {
+			return (sizeof(Header) + 63) / 64 * 64;
+		}
+
+		Slot* SlotAt(std::uint64_t position) const {
+			return reinterpret_cast<Slot*>(static_cast<unsigned char*>(_memory) + HeaderSize() + (position & (_header->capacity - 1)) * _header->slotStride);
+		}
+
+		static unsigned char* Payload(Slot* slot) {
+			return reinterpret_cast<unsigned char*>(slot + 1);
+		}
+	};
+
+	// Feeds a SharedWorkQueue into a ThreadPoolCPP, one per process
+	// A poller task takes tasks only while the local threadpool has room, so idle processes absorb the load of busy ones
+	// The poller runs inside a BlockingScope and sleeps with backoff while the ring is empty, there is no cross-process wake
+	// A started pump holds a worker, a spare thread takes its place, and ThreadPoolCPP::Wait and Shutdown(Drain) do not return until Stop
+	class SharedQueuePump {
+	public:
+		using lock_type = std::unique_lock<std::mutex>;
+		using handler_type = std::function<void(const void*, std::size_t)>;
+
+		static constexpr std::size_t DefaultBatch = 32;
+		static constexpr std::chrono::microseconds MaxBackoff = std::chrono::microseconds(1000);
+		static constexpr const char* Label = "shared";
+	protected:
+		// Shared with the poller task, which may still be queued when the pump is destroyed
+		struct State {
+			SharedWorkQueue* queue;
+			std::unordered_map<HandlerId, std::shared_ptr<handler_type>> handlers;
+			std::atomic_uint64_t unhandled;
+			bool running;
+			// Bumped by every Start, a poller queued by an earlier Start returns without polling
+			std::uint64_t generation;
+			// Pollers inside their loop, Stop waits for zero
+			std::size_t pollers;
+			std::mutex mutex;
+			std::condition_variable stopped;
+
+			State(SharedWorkQueue* q) : queue(q), unhandled(0), running(false), generation(0), pollers(0) {
+
+			}
+		};
+
+		ThreadPoolCPP& _threadpool;
+		TenantId _tenant;
+		std::size_t _batch;
+		std::shared_ptr<State> _state;
+	public:
+		// The queue must outlive the pump, stop the pump before shutting the threadpool down
+		// Throws std::invalid_argument when the threadpool has no spare thread to cover the poller
+		SharedQueuePump(ThreadPoolCPP& threadpool, SharedWorkQueue& queue, TenantId tenant = DefaultTenant, std::size_t batch = DefaultBatch) : _threadpool(threadpool), _tenant(tenant), _batch(batch ? batch : 1), _state(new State(&queue)) {
+			if (_threadpool.SpareThreads() == 0) {
+				throw std::invalid_argument("SharedQueuePump: the poller needs maxSpareThreads of at least one");
+			}
+		}
+
+		SharedQueuePump(const SharedQueuePump&) = delete;
+		SharedQueuePump& operator=(const SharedQueuePump&) = delete;
+
+		~SharedQueuePump() {
+			Stop();
+		}
+
+		// May be called while the pump runs, tasks popped before the handler is registered count as unhandled
+		// The same id must mean the same handler in every process
+		void Register(HandlerId id, handler_type handler) {
+			lock_type lock(_state->mutex);
+			_state->handlers[id] = std::make_shared<handler_type>(std::move(handler));
+		}
+
+		void Start() {
+			lock_type lock(_state->mutex);
+			if (_state->running) {
+				return;
+			}
+			_state->running = true;
+			_state->generation += 1;
+			_threadpool.PushTenantLabelled(_tenant, Label, &SharedQueuePump::Poll, &_threadpool, _tenant, _batch, _state, _state->generation);
+		}
+
+		// Returns once the poller has stopped taking tasks, tasks already pushed to the threadpool still run
+		void Stop() {
+			lock_type lock(_state->mutex);
+			_state->running = false;
+			_state->stopped.wait(lock, [this]() { return _state->pollers == 0; });
+		}
+
+		// Tasks popped with an id this process has no handler for, they are dropped
+		std::uint64_t Unhandled() const {
+			return _state->unhandled.load(std::memory_order_relaxed);
+		}
+	private:
+		static std::shared_ptr<handler_type> Find(State& state, HandlerId id) {
+			lock_type lock(state.mutex);
+			auto found = state.handlers.find(id);
+			return found == state.handlers.end() ? nullptr : found->second;
+		}
+
+		static void Poll(ThreadPoolCPP* threadpool, TenantId tenant, std::size_t batch, std::shared_ptr<State> state, std::uint64_t generation) {
+			{
+				lock_type lock(state->mutex);
+				if (!state->running || state->generation != generation) {
+					return;
+				}
+				state->pollers += 1;
+			}
+			BlockingScope scope;
+			std::vector<ThreadPoolCPP::work_type> works;
+			works.reserve(batch);
+			std::vector<unsigned char> payload(state->queue->PayloadSize());
+			std::chrono::microseconds backoff(1);
+			// Keeping about two tasks queued per worker leaves the rest of the ring to sibling processes
+			std::size_t room = threadpool->Size() * 2;
+			for (;;) {
+				{
+					lock_type lock(state->mutex);
+					if (!state->running || state->generation != generation) {
+						break;
+					}
+				}
+				std::size_t queued = threadpool->QueuedTasks();
+				HandlerId id;
+				std::size_t size;
+				while (works.size() < batch && queued + works.size() < room && state->queue->Pop(id, payload.data(), size)) {
+					std::shared_ptr<handler_type> handler = Find(*state, id);
+					if (!handler) {
+						state->unhandled.fetch_add(1, std::memory_order_relaxed);
+						continue;
+					}
+					std::vector<unsigned char> copy(payload.begin(), payload.begin() + size);
+					works.push_back([handler, copy]() { (*handler)(copy.data(), copy.size()); });
+				}
+				if (!works.empty()) {
+					threadpool->PushBatch(works, tenant, Label);
+					backoff = std::chrono::microseconds(1);
+					continue;
+				}
+				std::this_thread::sleep_for(backoff);
+				backoff = backoff * 2 > MaxBackoff ? MaxBackoff : backoff * 2;
+			}
+			lock_type lock(state->mutex);
+			state->pollers -= 1;
+			state->stopped.notify_all();
+		}
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+namespace Threading {
+	// Serial executor layered on any threadpool exposing Push(functor, args...)
+	// Work pushed to one strand runs in FIFO order and never concurrently, different strands run in parallel
+	template <class _PoolTy>
+	class Strand {
+	public:
+		using threadpool_type = _PoolTy;
+		using work_type = std::function<void()>;
+	protected:
+		// Intrusive multi-producer single-consumer queue (Vyukov), the stub node keeps the queue non-empty
+		struct Node {
+			std::atomic<Node*> next;
+
+			Node() : next(nullptr) {
+
+			}
+		};
+
+		struct WorkNode : Node {
+			work_type work;
+
+			WorkNode(work_type w) : Node(), work(std::move(w)) {
+
+			}
+		};
+
+		threadpool_type& _threadpool;
+		std::size_t _batchSize;
+		std::atomic<Node*> _head;
+		Node* _tail;
+		Node _stub;
+		std::atomic_size_t _pending;
+	public:
+		static constexpr std::size_t DefaultBatchSize = 64;
+
+		Strand(threadpool_type& threadpool, std::size_t batchSize = DefaultBatchSize) : _threadpool(threadpool), _batchSize(batchSize ? batchSize : 1), _head(&_stub), _tail(&_stub), _stub(), _pending(0) {
+
+		}
+
+		Strand(const Strand&) = delete;
+		Strand& operator=(const Strand&) = delete;
+
+		~Strand() {
+			// The threadpool holds a pointer to this strand while work is pending
+			Wait();
+		}
+
+		template <class _FuncTy, class..._ArgsTy>
+		void Push(_FuncTy functor, _ArgsTy...args) {
+			Enqueue(new WorkNode([functor, args...]() { Execute(functor, args...); }));
+			// Only the push that makes the strand non-empty schedules it, the drain reschedules itself while work remains
+			if (_pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+				_threadpool.Push(&Strand::Drain, this);
+			}
+		}
+
+		void Wait() {
+			while (_pending.load(std::memory_order_acquire) != 0) {
+				std::this_thread::yield();
+			}
+		}
+
+		bool Empty() const {
+			return _pending.load(std::memory_order_acquire) == 0;
+		}
+
+		threadpool_type& ThreadPool() {
+			return _threadpool;
+		}
+	private:
+		void Enqueue(Node* node) {
+			node->next.store(nullptr, std::memory_order_relaxed);
+			Node* previous = _head.exchange(node, std::memory_order_acq_rel);
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		// Single consumer, returns nullptr if a producer has exchanged the head but not yet linked its node
+		WorkNode* Dequeue() {
+			Node* tail = _tail;
+			Node* next = tail->next.load(std::memory_order_acquire);
+			if (tail == &_stub) {
+				if (next == nullptr) {
+					return nullptr;
+				}
+				_tail = next;
+				tail = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+			if (next != nullptr) {
+				_tail = next;
+				return static_cast<WorkNode*>(tail);
+			}
+			if (tail != _head.load(std::memory_order_acquire)) {
+				return nullptr;
+			}
+			Enqueue(&_stub);
+			next = tail->next.load(std::memory_order_acquire);
+			if (next != nullptr) {
+				_tail = next;
+				return static_cast<WorkNode*>(tail);
+			}
+			return nullptr;
+		}
+
+		void Drain() {
+			// Work is counted after it is enqueued, so at least this many nodes are reachable from the tail
+			std::size_t available = _pending.load(std::memory_order_acquire);
+			std::size_t batch = available < _batchSize ? available : _batchSize;
+			std::size_t executed = 0;
+			while (executed < batch) {
+				WorkNode* node = Dequeue();
+				if (node == nullptr) {
+					// A producer is between exchanging the head and linking its node
+					std::this_thread::yield();
+					continue;
+				}
+				node->work();
+				delete node;
+				++executed;
+			}
+			// Yield the worker between batches so a busy strand cannot starve its siblings
+			if (_pending.fetch_sub(executed, std::memory_order_acq_rel) != executed) {
+				_threadpool.Push(&Strand::Drain, this);
+			}
+		}
+
+		template <class _FuncTy, class..._ArgsTy>
+		static inline void Execute(_FuncTy functor, _ArgsTy...args) {
+			std::invoke(functor, args...);
+		}
+	};
+}
\ No newline at end of file
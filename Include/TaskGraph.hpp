@@ -0,0 +1,250 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "ThreadPoolCPP.hpp"
+
+namespace Threading {
+	using NodeId = std::size_t;
+
+	// Dependency graph built once and run many times in the style of Taskflow
+	// A run only resets each node's predecessor counter, nodes are pushed to the threadpool as their last predecessor finishes
+	// The finishing worker keeps one ready successor for itself instead of queueing it, so chains run without a trip through the queue
+	// Any threadpool with Push(functor, args...) works, the graph must outlive the run and not be changed or run again before Wait returns
+	class TaskGraph {
+	public:
+		using work_type = std::function<void()>;
+		using lock_type = std::unique_lock<std::mutex>;
+	protected:
+		// Laid out by Compile, every run reuses them, aligned so counters of neighbouring nodes do not share a cache line
+		struct alignas(64) Node {
+			TaskGraph* graph;
+			work_type* work;
+			std::atomic_size_t pending;
+			std::size_t predecessors;
+			// Range of _successors
+			std::size_t firstSuccessor;
+			std::size_t lastSuccessor;
+		};
+
+		std::vector<work_type> _works;
+		std::vector<std::pair<NodeId, NodeId>> _edges;
+		bool _compiled;
+		std::unique_ptr<Node[]> _nodes;
+		std::vector<Node*> _successors;
+		std::vector<Node*> _sources;
+		// Set by Start, the push is instantiated for the threadpool's type so queueing a node allocates nothing here
+		void* _threadpool;
+		void (*_push)(void*, Node*);
+		std::atomic_size_t _remaining;
+		std::atomic_bool _failed;
+		std::exception_ptr _error;
+		bool _done;
+		std::mutex _mutex;
+		std::condition_variable _conditionVariable;
+	public:
+		TaskGraph() : _compiled(false), _threadpool(nullptr), _push(nullptr), _remaining(0), _failed(false), _done(true) {
+
+		}
+
+		TaskGraph(const TaskGraph&) = delete;
+		TaskGraph& operator=(const TaskGraph&) = delete;
+
+		NodeId AddNode(work_type work) {
+			_works.push_back(std::move(work));
+			_compiled = false;
+			return _works.size() - 1;
+		}
+
+		// from finishes before to starts, throws std::out_of_range for unknown nodes
+		void AddEdge(NodeId from, NodeId to) {
+			if (from >= _works.size() || to >= _works.size()) {
+				throw std::out_of_range("TaskGraph: unknown node");
+			}
+			_edges.emplace_back(from, to);
+			_compiled = false;
+		}
+
+		std::size_t Nodes() const {
+			return _works.size();
+		}
+
+		std::size_t Edges() const {
+			return _edges.size();
+		}
+
+		// Lays out the nodes after they or the edges changed, Start calls it, throws std::invalid_argument when the edges form a cycle
+		void Compile() {
+			if (_compiled) {
+				return;
+			}
+			std::size_t count = _works.size();
+			std::unique_ptr<Node[]> nodes(new Node[count]);
+			std::vector<std::size_t> degrees(count + 1, 0);
+			for (std::size_t i = 0; i < count; ++i) {
+				nodes[i].graph = this;
+				nodes[i].work = &_works[i];
+				nodes[i].pending.store(0, std::memory_order_relaxed);
+				nodes[i].predecessors = 0;
+			}
+			for (const std::pair<NodeId, NodeId>& edge : _edges) {
+				degrees[edge.first + 1] += 1;
+				nodes[edge.second].predecessors += 1;
+			}
+			for (std::size_t i = 0; i < count; ++i) {
+				degrees[i + 1] += degrees[i];
+				nodes[i].firstSuccessor = degrees[i];
+				nodes[i].lastSuccessor = degrees[i];
+			}
+			std::vector<Node*> successors(_edges.size());
+			for (const std::pair<NodeId, NodeId>& edge : _edges) {
+				successors[nodes[edge.first].lastSuccessor++] = &nodes[edge.second];
+			}
+			// Kahn's algorithm, a node never reached has a predecessor on a cycle
+			std::vector<Node*> sources;
+			std::vector<std::size_t> pending(count);
+			std::vector<Node*> ready;
+			for (std::size_t i = 0; i < count; ++i) {
+				pending[i] = nodes[i].predecessors;
+				if (pending[i] == 0) {
+					sources.push_back(&nodes[i]);
+					ready.push_back(&nodes[i]);
+				}
+			}
+			std::size_t reached = 0;
+			while (!ready.empty()) {
+				Node* node = ready.back();
+				ready.pop_back();
+				++reached;
+				for (std::size_t i = node->firstSuccessor; i < node->lastSuccessor; ++i) {
+					if (--pending[successors[i] - nodes.get()] == 0) {
+						ready.push_back(successors[i]);
+					}
+				}
+			}
+			if (reached != count) {
+				throw std::invalid_argument("TaskGraph: the edges form a cycle");
+			}
+			_nodes = std::move(nodes);
+			_successors = std::move(successors);
+			_sources = std::move(sources);
+			_compiled = true;
+		}
+
+		// Queues the nodes without predecessors and returns, Wait blocks until every node ran
+		template <class _PoolTy>
+		void Start(_PoolTy& threadpool) {
+			Compile();
+			{
+				lock_type lock(_mutex);
+				if (!_done) {
+					throw std::logic_error("TaskGraph: already running");
+				}
+				_done = _works.empty();
+				_error = nullptr;
+			}
+			if (_works.empty()) {
+				return;
+			}
+			for (std::size_t i = 0; i < _works.size(); ++i) {
+				_nodes[i].pending.store(_nodes[i].predecessors, std::memory_order_relaxed);
+			}
+			_failed.store(false, std::memory_order_relaxed);
+			_remaining.store(_works.size(), std::memory_order_relaxed);
+			_threadpool = &threadpool;
+			_push = &TaskGraph::PushNode<_PoolTy>;
+			for (Node* source : _sources) {
+				Release(source);
+			}
+		}
+
+		// Rethrows the first exception a node or a push to the threadpool threw, the nodes after a failure are skipped but still counted down
+		// Marks the wait as blocking so a ThreadPoolCPP worker running a graph on its own threadpool can be covered by a spare
+		void Wait() {
+			std::exception_ptr error;
+			{
+				lock_type lock(_mutex);
+				if (!_done) {
+					BlockingScope scope;
+					_conditionVariable.wait(lock, [this]() { return _done; });
+				}
+				std::swap(error, _error);
+			}
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+
+		template <class _PoolTy>
+		void Run(_PoolTy& threadpool) {
+			Start(threadpool);
+			Wait();
+		}
+	private:
+		template <class _PoolTy>
+		static void PushNode(void* threadpool, Node* node) {
+			static_cast<_PoolTy*>(threadpool)->Push(&TaskGraph::Execute, node);
+		}
+
+		static void Execute(Node* node) {
+			TaskGraph* graph = node->graph;
+			while (node != nullptr) {
+				if (!graph->_failed.load(std::memory_order_relaxed)) {
+					try {
+						(*node->work)();
+					} catch (...) {
+						graph->Fail(std::current_exception());
+					}
+				}
+				Node* next = nullptr;
+				for (std::size_t i = node->firstSuccessor; i < node->lastSuccessor; ++i) {
+					Node* successor = graph->_successors[i];
+					if (successor->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+						if (next == nullptr) {
+							next = successor;
+						} else {
+							graph->Release(successor);
+						}
+					}
+				}
+				node = next;
+				// The run's last node lets Wait return, the graph may be destroyed or restarted at once and next is null then
+				graph->Finish();
+			}
+		}
+
+		// A node the threadpool refused runs here with the graph failed, so it is skipped but still releases its successors
+		void Release(Node* node) {
+			try {
+				_push(_threadpool, node);
+			} catch (...) {
+				Fail(std::current_exception());
+				Execute(node);
+			}
+		}
+
+		void Fail(std::exception_ptr error) {
+			lock_type lock(_mutex);
+			if (!_error) {
+				_error = error;
+			}
+			_failed.store(true, std::memory_order_relaxed);
+		}
+
+		void Finish() {
+			if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				lock_type lock(_mutex);
+				_done = true;
+				_conditionVariable.notify_all();
+			}
+		}
+	};
+}
\ No newline at end of file
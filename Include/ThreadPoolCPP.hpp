@@ -1,111 +1,1220 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <vector>
 #include <thread>
 #include <mutex>
 #include <functional>
+#include <memory>
 #include <queue>
+#include <stdexcept>
+#include <string>
+#include "DeterministicSchedule.hpp"
+#include "FairQueue.hpp"
+#include "HugePageArena.hpp"
+#include "ThreadPoolProfile.hpp"
+#include "ThreadPoolTrace.hpp"
+#include "ThreadSanitizer.hpp"
+#include "WorkerThread.hpp"
 
 namespace Threading {
+	struct ThreadPoolCPPSettings {
+		// Extra workers started while tasks are inside a BlockingScope, they park again once the scope ends
+		std::size_t maxSpareThreads = 0;
+		// Backs the task queues with a pool arena and gives every worker a scratch arena, both on huge pages when available
+		bool hugePageArena = false;
+		std::size_t arenaChunkSize = HugePageArena::DefaultChunkSize;
+		// Most trivial tasks one queued batch runs, see PushTrivial
+		std::size_t coalesceLimit = 64;
+		// Starts no worker up front, pushed work that finds none waiting starts one, up to the active thread count
+		bool lazyStart = false;
+		// The constructor returns once every worker it started is waiting, false returns right after spawning them
+		bool waitForWorkers = true;
+		// Most tasks a worker takes per queue lock, it takes fewer when the queue is short so other workers still find work
+		std::size_t maxDequeueBatch = 16;
+		// Stack reserved per worker in bytes, zero keeps the platform default (8 MiB on most Linux systems, 1 MiB on Windows)
+		std::size_t stackSize = 0;
+		// Workers idle this long hand their arena's free memory back to the system, zero never trims
+		std::chrono::milliseconds idleTrim = std::chrono::milliseconds(1000);
+	};
+
+	enum class ShutdownMode {
+		// Runs queued tasks, including ones they push, until the queue is empty or the deadline passes
+		Drain,
+		// Drops queued tasks at once and waits for running ones
+		DropQueued,
+		// Drains until the deadline, then drops what is queued and returns even if tasks are still running
+		Deadline
+	};
+
+	struct ShutdownReport {
+		std::size_t dropped;
+		// Labels of dropped tasks that had one
+		std::vector<const char*> droppedLabels;
+		// Workers still inside a task when a Deadline shutdown returned
+		std::size_t abandoned;
+		bool timedOut;
+		std::chrono::nanoseconds elapsed;
+	};
+
+	struct MemoryStats {
+		std::size_t threads;
+		// Address space reserved for worker stacks, only the pages a worker touched are resident
+		std::size_t stackBytes;
+		// Queue and worker arenas, memory released by Trim stays mapped
+		std::size_t arenaMappedBytes;
+		std::size_t arenaAllocatedBytes;
+		std::size_t arenaTrimmedBytes;
+		// Queued tasks, dequeue batch slots and trace rings
+		std::size_t bookkeepingBytes;
+	};
+
 	class ThreadPoolCPP {
 	public:
-		using thread_type = std::thread;
+		using thread_type = WorkerThread;
 		using thread_container = std::vector<thread_type>;
 
 		using lock_type = std::unique_lock<std::mutex>;
 		using work_type = std::function<void()>;
-		using work_container = std::queue<work_type>;
+		using deadline_type = std::chrono::steady_clock::time_point;
+
+		struct WorkItem {
+			work_type work;
+			// Tracing data, label must have static storage duration and enqueueTime is zero when tracing was disabled at Push
+			const char* label;
+			std::uint64_t enqueueTime;
+			// Submission number while deterministic, zero otherwise
+			std::uint64_t sequence;
+			// Default constructed when the task has no deadline
+			deadline_type deadline;
+			// Runs instead of work when the deadline passed before a worker got to the task, may be null
+			std::unique_ptr<work_type> expired;
+			// Set on the queued tasks that run coalesced trivial tasks, those count the tasks they ran instead of themselves
+			bool coalesced;
+		};
+		// Tasks are taken from tenants in weighted round-robin order, FIFO or earliest deadline first within a tenant
+		using work_container = FairQueue<WorkItem, ArenaAllocator<WorkItem>>;
+
+		static constexpr std::size_t DefaultTraceCapacity = 1 << 16;
+		static constexpr std::chrono::milliseconds DefaultReplayTimeout = std::chrono::milliseconds(1000);
+		// Trivial tasks pushed from inside trivial tasks run inline up to this depth, then they are batched
+		static constexpr std::size_t MaxInlineDepth = 16;
+		// Trace and profile label of the queued tasks that run coalesced trivial tasks, WorkItem::coalesced is what identifies them
+		static constexpr const char* CoalescedLabel = "coalesced";
+
+		// Identifies the threadpool and worker running on the calling thread, threadpool is nullptr outside workers
+		struct WorkerContext {
+			ThreadPoolCPP* threadpool;
+			std::size_t index;
+			std::size_t blockingDepth;
+			// Holds the deterministic mode's single execution slot
+			bool serialized;
+			// Trivial tasks running inline on this thread
+			std::size_t inlineDepth;
+		};
 	protected:
-		bool _run;
-		bool _pause;
+		std::atomic_bool _run;
+		std::atomic_bool _pause;
 		std::mutex _workMutex;
+		// Only touched under _workMutex, null unless ThreadPoolCPPSettings::hugePageArena
+		std::unique_ptr<HugePageArena> _queueArena;
 		work_container _works;
+		// One per worker index, each used only by its own worker
+		std::vector<std::unique_ptr<HugePageArena>> _workerArenas;
+		// Worker arena stats published by their workers for MemoryUsage
+		struct ArenaUsage {
+			std::atomic_size_t mappedBytes;
+			std::atomic_size_t allocatedBytes;
+			std::atomic_size_t trimmedBytes;
+
+			ArenaUsage() : mappedBytes(0), allocatedBytes(0), trimmedBytes(0) {
+
+			}
+		};
+		std::vector<std::unique_ptr<ArenaUsage>> _arenaUsage;
 		std::mutex _sleepMutex;
 		std::condition_variable _conditionVariable;
+		// Workers with an index at or above _activeThreads sleep here instead of taking work
+		std::condition_variable _parkVariable;
+		// Signalled under _sleepMutex as each worker returns
+		std::condition_variable _exitVariable;
+		std::size_t _exitedThreads;
+		// Reserved up front so spare workers can be appended without moving running threads
 		thread_container _threads;
+		std::mutex _threadsMutex;
+		std::size_t _numberThreads;
+		std::size_t _maxThreads;
+		std::atomic_size_t _startedThreads;
 		std::atomic_uint64_t _waitingThreads;
+		std::atomic_size_t _activeThreads;
+		std::atomic_size_t _blockedThreads;
+		std::atomic_uint64_t _completedTasks;
+		std::atomic_uint64_t _expiredTasks;
+		std::atomic_bool _tracing;
+		std::mutex _traceMutex;
+		std::vector<std::unique_ptr<Trace::Ring>> _traceRings;
+		std::atomic_bool _profiling;
+		std::atomic_bool _profileCounters;
+		std::mutex _profileMutex;
+		// One per worker index, created by the first EnableProfiling
+		std::vector<std::unique_ptr<Profile::Worker>> _profiles;
+		// Deterministic mode drains the queue into _ready and runs one task at a time in seeded or replayed order
+		struct ReadyItem {
+			WorkItem item;
+			work_container::handle_type tenant;
+		};
+		std::atomic_bool _deterministic;
+		bool _replaying;
+		bool _serialBusy;
+		std::uint64_t _sequence;
+		std::uint64_t _scheduleState;
+		std::size_t _replayPosition;
+		std::chrono::milliseconds _replayTimeout;
+		Schedule _replay;
+		Schedule _recorded;
+		std::deque<ReadyItem> _ready;
+		// Tasks a worker took under one lock, its owner and idle workers claim them one at a time
+		struct alignas(64) WorkerBatch {
+			// Next slot to claim in the high half and slot count in the low half, so one compare-exchange claims a slot
+			std::atomic_uint64_t state;
+			// Claimed slots whose task has been moved out
+			std::atomic_size_t taken;
+			std::unique_ptr<ReadyItem[]> items;
+
+			WorkerBatch(std::size_t capacity) : state(0), taken(0), items(new ReadyItem[capacity]) {
+
+			}
+		};
+		std::vector<std::unique_ptr<WorkerBatch>> _batches;
+		std::atomic_uint64_t _dequeueLocks;
+		std::atomic_size_t _readyCount;
+		std::condition_variable _deterministicVariable;
+		// Trivial tasks waiting for a batch task, every started run of coalesceLimit tasks has one queued in _works
+		std::mutex _batchMutex;
+		std::deque<work_type> _batch;
+		std::size_t _coalesceLimit;
+		bool _lazyStart;
+		std::size_t _maxDequeueBatch;
+		std::size_t _stackSize;
+		std::chrono::milliseconds _idleTrim;
+		// Processor each worker index is pinned to, -1 leaves it unpinned, guarded by _threadsMutex
+		std::vector<int> _affinity;
 	public:
-		ThreadPoolCPP(std::size_t numberThreads) : _waitingThreads(0), _run(true), _pause(false) {
+		ThreadPoolCPP(std::size_t numberThreads, ThreadPoolCPPSettings settings = ThreadPoolCPPSettings()) :
+				_run(true),
+				_pause(false),
+				_queueArena(settings.hugePageArena ? new HugePageArena(settings.arenaChunkSize) : nullptr),
+				_works(ArenaAllocator<WorkItem>(_queueArena.get())),
+				_exitedThreads(0),
+				_numberThreads(numberThreads),
+				_maxThreads(numberThreads + settings.maxSpareThreads),
+				_startedThreads(0),
+				_waitingThreads(0),
+				_activeThreads(numberThreads),
+				_blockedThreads(0),
+				_completedTasks(0),
+				_expiredTasks(0),
+				_tracing(false),
+				_profiling(false),
+				_profileCounters(false),
+				_deterministic(false),
+				_replaying(false),
+				_serialBusy(false),
+				_sequence(0),
+				_scheduleState(0),
+				_replayPosition(0),
+				_replayTimeout(DefaultReplayTimeout),
+				_dequeueLocks(0),
+				_readyCount(0),
+				_coalesceLimit(settings.coalesceLimit ? settings.coalesceLimit : 1),
+				_lazyStart(settings.lazyStart),
+				_maxDequeueBatch(settings.maxDequeueBatch ? settings.maxDequeueBatch : 1),
+				_stackSize(settings.stackSize),
+				_idleTrim(settings.idleTrim) {
+			_threads.reserve(_maxThreads);
+			_affinity.assign(_maxThreads, -1);
+			for (std::size_t i = 0; i < _maxThreads; ++i) {
+				_batches.emplace_back(new WorkerBatch(_maxDequeueBatch));
+			}
+			if (settings.hugePageArena) {
+				for (std::size_t i = 0; i < _maxThreads; ++i) {
+					_workerArenas.emplace_back(new HugePageArena(settings.arenaChunkSize));
+					_arenaUsage.emplace_back(new ArenaUsage());
+				}
+			}
+			if (_lazyStart) {
+				return;
+			}
 			for (std::size_t i = 0; i < numberThreads; ++i) {
-				_threads.push_back(thread_type(&ThreadPoolCPP::FunctionWrapper, this));
+				StartThread();
+			}
+			if (settings.waitForWorkers) {
+				Wait();
 			}
-			Wait();
 		}
 
+		// Queued tasks are dropped, returns once running tasks finish
 		~ThreadPoolCPP() {
+			Shutdown(ShutdownMode::DropQueued);
+		}
+
+		// Stops the workers and reports the tasks that never ran, later pushes are queued but never run
+		// After a Deadline shutdown with abandoned tasks, exit the process rather than destroy the threadpool, destruction waits for them
+		ShutdownReport Shutdown(ShutdownMode mode, std::chrono::milliseconds timeout = (std::chrono::milliseconds::max)()) {
+			using clock_type = std::chrono::steady_clock;
+			clock_type::time_point start = clock_type::now();
+			clock_type::time_point deadline = timeout >= std::chrono::duration_cast<std::chrono::milliseconds>((clock_type::time_point::max)() - start) ? (clock_type::time_point::max)() : start + timeout;
+			ShutdownReport report{ 0, {}, 0, false, std::chrono::nanoseconds(0) };
+
+			if (mode != ShutdownMode::DropQueued) {
+				Resume();
+				while (_run.load(std::memory_order_acquire) && !Idle()) {
+					if (clock_type::now() >= deadline) {
+						report.timedOut = true;
+						break;
+					}
+					std::this_thread::yield();
+				}
+			}
 			Stop();
-			Resume();
-			for (thread_type& t : _threads) {
-				if (t.joinable()) {
-					t.join();
+			Drop(report);
+			{
+				lock_type lock(_sleepMutex);
+				auto exited = [this]() { return _exitedThreads == _startedThreads.load(std::memory_order_acquire); };
+				if (mode != ShutdownMode::Deadline) {
+					_exitVariable.wait(lock, exited);
+				} else if (!_exitVariable.wait_until(lock, deadline, exited)) {
+					report.timedOut = true;
+					report.abandoned = _startedThreads.load(std::memory_order_acquire) - _exitedThreads;
 				}
 			}
+			if (report.abandoned == 0) {
+				{
+					lock_type lock(_threadsMutex);
+					for (thread_type& t : _threads) {
+						if (t.joinable()) {
+							t.join();
+						}
+					}
+				}
+				// Workers hand unstarted tasks of their batch back as they stop
+				Drop(report);
+			}
+			report.elapsed = clock_type::now() - start;
+			return report;
 		}
 
 		template <class _FuncTy, class..._ArgsTy>
 		void Push(_FuncTy functor, _ArgsTy...args) {
+			PushLabelled(nullptr, functor, args...);
+		}
+
+		// Label is shown for the task in traces, it must outlive the threadpool (e.g. a string literal)
+		template <class _FuncTy, class..._ArgsTy>
+		void PushLabelled(const char* label, _FuncTy functor, _ArgsTy...args) {
+			PushTenantLabelled(DefaultTenant, label, functor, args...);
+		}
+
+		template <class _FuncTy, class..._ArgsTy>
+		void PushTenant(TenantId tenant, _FuncTy functor, _ArgsTy...args) {
+			PushTenantLabelled(tenant, nullptr, functor, args...);
+		}
+
+		template <class _FuncTy, class..._ArgsTy>
+		void PushTenantLabelled(TenantId tenant, const char* label, _FuncTy functor, _ArgsTy...args) {
 			//std::_Function_args<_FuncTy(_ArgsTy...)>;
-			lock_type lock(_workMutex);
+			std::uint64_t enqueueTime = _tracing.load(std::memory_order_acquire) ? Trace::Now() : 0;
 			// Type-deduction around std::invoke is sensitive, wrapping the call in another function removes multiple compiler errors
-			_works.emplace([functor, args...]() { Execute(functor, args...); });
-			WakeOne();
+			Enqueue(tenant, WorkItem{ [functor, args...]() { Execute(functor, args...); }, label, enqueueTime, 0, deadline_type(), nullptr, false });
+		}
+
+		// Dropped and counted in ExpiredTasks() instead of run when the deadline has passed by the time a worker gets to it
+		template <class _FuncTy, class..._ArgsTy>
+		void PushDeadline(deadline_type deadline, _FuncTy functor, _ArgsTy...args) {
+			PushDeadlineTenant(DefaultTenant, deadline, nullptr, functor, args...);
+		}
+
+		// Tenants created with earliestDeadlineFirst run these in deadline order, onExpired runs on a worker for a dropped task
+		template <class _FuncTy, class..._ArgsTy>
+		void PushDeadlineTenant(TenantId tenant, deadline_type deadline, work_type onExpired, _FuncTy functor, _ArgsTy...args) {
+			std::uint64_t enqueueTime = _tracing.load(std::memory_order_acquire) ? Trace::Now() : 0;
+			std::unique_ptr<work_type> expired(onExpired ? new work_type(std::move(onExpired)) : nullptr);
+			Enqueue(tenant, WorkItem{ [functor, args...]() { Execute(functor, args...); }, nullptr, enqueueTime, 0, deadline, std::move(expired), false });
+		}
+
+		// Queues every task under one lock acquisition for producers that generate work in bursts, leaves works empty
+		// If queueing throws, the tasks queued so far still run and works keeps the rest, starting with the one that failed
+		void PushBatch(std::vector<work_type>& works, TenantId tenant = DefaultTenant, const char* label = nullptr) {
+			if (works.empty()) {
+				return;
+			}
+			std::uint64_t enqueueTime = _tracing.load(std::memory_order_acquire) ? Trace::Now() : 0;
+			std::size_t count = 0;
+			std::exception_ptr error;
+			lock_type lock(_workMutex);
+			CheckTenant(tenant);
+			bool deterministic = _deterministic.load(std::memory_order_relaxed);
+			try {
+				for (; count < works.size(); ++count) {
+					_works.Push(tenant, WorkItem{ std::move(works[count]), label, enqueueTime, deterministic ? ++_sequence : 0, deadline_type(), nullptr, false });
+				}
+			} catch (...) {
+				error = std::current_exception();
+			}
+			works.erase(works.begin(), works.begin() + count);
+			if (deterministic) {
+				_deterministicVariable.notify_all();
+			}
+			lock.unlock();
+			if (count == 1) {
+				WakeOne();
+			} else if (count > 1) {
+				if (WaitingThreads() != 0) {
+					lock_type sleepLock(_sleepMutex);
+					_conditionVariable.notify_all();
+				}
+			}
+			for (std::size_t i = 0; _lazyStart && i < count && _waitingThreads.load(std::memory_order_relaxed) == 0; ++i) {
+				StartOnDemand();
+			}
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+
+		// For tasks cheaper than a trip through the queue, in no particular order relative to other tasks
+		// Runs the task on the caller when it is one of this threadpool's workers or no worker is idle
+		// Otherwise it joins a batch that takes a single queue slot and wake, deterministic mode queues it normally
+		template <class _FuncTy, class..._ArgsTy>
+		void PushTrivial(_FuncTy functor, _ArgsTy...args) {
+			if (_deterministic.load(std::memory_order_acquire) || !_run.load(std::memory_order_acquire)) {
+				Push(functor, args...);
+				return;
+			}
+			WorkerContext& context = CurrentWorker();
+			// A lazy threadpool that can still start a worker is not saturated
+			bool saturated = context.threadpool == this || (_waitingThreads.load(std::memory_order_relaxed) == 0 && !(_lazyStart && _startedThreads.load(std::memory_order_acquire) < _activeThreads.load(std::memory_order_acquire)));
+			if (saturated && !_pause.load(std::memory_order_acquire) && context.inlineDepth < MaxInlineDepth) {
+				++context.inlineDepth;
+				Execute(functor, args...);
+				--context.inlineDepth;
+				_completedTasks.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			bool schedule;
+			{
+				lock_type lock(_batchMutex);
+				_batch.emplace_back([functor, args...]() { Execute(functor, args...); });
+				schedule = _coalesceLimit == 1 || _batch.size() % _coalesceLimit == 1;
+			}
+			if (schedule) {
+				std::uint64_t enqueueTime = _tracing.load(std::memory_order_acquire) ? Trace::Now() : 0;
+				Enqueue(DefaultTenant, WorkItem{ [this]() { RunBatch(); }, CoalescedLabel, enqueueTime, 0, deadline_type(), nullptr, true });
+			}
+		}
+
+		// Registers a task source sharing the workers with every other tenant, work pushed without a tenant goes to DefaultTenant
+		TenantId CreateTenant(TenantSettings settings) {
+			lock_type lock(_workMutex);
+			return _works.AddTenant(std::move(settings));
+		}
+
+		std::size_t Tenants() {
+			lock_type lock(_workMutex);
+			return _works.Tenants();
+		}
+
+		TenantMetrics GetTenantMetrics(TenantId tenant) {
+			lock_type lock(_workMutex);
+			CheckTenant(tenant);
+			return _works.Metrics(tenant);
 		}
 
 		void WakeOne() {
-			_conditionVariable.notify_one();
+			if (WaitingThreads() != 0) {
+				// The sleeper holds _sleepMutex from its check until it waits, so the notify cannot fall in between
+				lock_type lock(_sleepMutex);
+				_conditionVariable.notify_one();
+			}
+		}
+
+		// Waker side of the sleep handshake, pairs with the fence in FunctionWrapper so either the sleeper sees the new work or this sees the sleeper
+		// ThreadSanitizer does not model fences, there a read-modify-write orders the two through _waitingThreads itself
+		std::uint64_t WaitingThreads() {
+#if THREADPOOL_TSAN
+			return _waitingThreads.fetch_add(0, std::memory_order_seq_cst);
+#else
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			return _waitingThreads.load(std::memory_order_relaxed);
+#endif
 		}
 
 		void WakeAll() {
+			lock_type lock(_sleepMutex);
 			_conditionVariable.notify_all();
+			_parkVariable.notify_all();
 		}
 
+		// Workers exit after their current task, queued tasks stay queued
 		void Stop() {
-			_run = false;
+			{
+				lock_type lock(_sleepMutex);
+				_run.store(false, std::memory_order_release);
+			}
+			WakeAll();
+			lock_type lock(_workMutex);
+			_deterministicVariable.notify_all();
 		}
 
 		void Resume() {
-			_pause = false;
+			{
+				lock_type lock(_sleepMutex);
+				_pause.store(false, std::memory_order_release);
+			}
 			WakeAll();
 		}
 
 		void Pause() {
-			_pause = true;
+			_pause.store(true, std::memory_order_release);
 		}
 
 		void Wait() {
 			// Wait until all threads are waiting
-			while ((_waitingThreads < _threads.size()) || !(_works.empty() || _pause)) {
+			while (_run.load(std::memory_order_acquire) && !(Idle() || (_waitingThreads >= _startedThreads.load(std::memory_order_acquire) && _pause.load(std::memory_order_acquire)))) {
 				std::this_thread::yield();
 			}
 			// This lock is required so that Wake cannot be called before all threads are asleep
 			lock_type lock(_sleepMutex);
 		}
 
+		// Number of workers the threadpool was constructed with, spare workers are not included
+		std::size_t Size() const {
+			return _numberThreads;
+		}
+
+		// Workers started on top of Size while tasks are inside a BlockingScope
+		std::size_t SpareThreads() const {
+			return _maxThreads - _numberThreads;
+		}
+
+		std::size_t StartedThreads() const {
+			return _startedThreads.load(std::memory_order_acquire);
+		}
+
+		std::size_t BlockedThreads() const {
+			return _blockedThreads.load(std::memory_order_acquire);
+		}
+
+		std::size_t ActiveThreads() const {
+			return _activeThreads.load(std::memory_order_acquire);
+		}
+
+		// Workers inside a task or about to take one, a snapshot that is stale as soon as it returns
+		std::size_t BusyThreads() const {
+			std::size_t started = _startedThreads.load(std::memory_order_acquire);
+			std::size_t waiting = (std::size_t)_waitingThreads.load(std::memory_order_acquire);
+			return started > waiting ? started - waiting : 0;
+		}
+
+		// Pins the worker with this index to one processor, a worker not started yet is pinned when it starts
+		// Returns false if the index is out of range or pinning a running worker failed
+		bool SetWorkerAffinity(std::size_t index, int cpu) {
+			lock_type lock(_threadsMutex);
+			if (index >= _affinity.size()) {
+				return false;
+			}
+			_affinity[index] = cpu;
+			return index >= _threads.size() || _threads[index].SetAffinity(cpu);
+		}
+
+		// Processor the worker was last pinned to, -1 if it never was or the index is out of range
+		int WorkerAffinity(std::size_t index) {
+			lock_type lock(_threadsMutex);
+			return index < _affinity.size() ? _affinity[index] : -1;
+		}
+
+		// Limits how many workers take work, the rest stay parked, clamped to [1, Size()]
+		void SetActiveThreads(std::size_t numberThreads) {
+			numberThreads = numberThreads < 1 ? 1 : (numberThreads > _numberThreads ? _numberThreads : numberThreads);
+			{
+				lock_type lock(_sleepMutex);
+				_activeThreads.store(numberThreads, std::memory_order_release);
+			}
+			// Workers above a lowered limit must move to the park variable so they cannot swallow a WakeOne
+			WakeAll();
+		}
+
+		std::uint64_t CompletedTasks() const {
+			return _completedTasks.load(std::memory_order_relaxed);
+		}
+
+		// Deadline tasks dropped because their deadline had passed, not included in CompletedTasks()
+		std::uint64_t ExpiredTasks() const {
+			return _expiredTasks.load(std::memory_order_relaxed);
+		}
+
+		// Times workers took the queue lock to dequeue, CompletedTasks() / DequeueLocks() is the average batch
+		std::uint64_t DequeueLocks() const {
+			return _dequeueLocks.load(std::memory_order_relaxed);
+		}
+
+		// Includes tasks a worker took with a dequeue batch but has not started yet
+		std::size_t QueuedTasks() const {
+			return _works.Size() + _readyCount.load(std::memory_order_acquire) + BatchedTasks();
+		}
+
+		// Memory the threadpool holds itself, heap memory owned by queued functors is not included
+		// Worker arenas are reported as of their worker's last task or trim
+		MemoryStats MemoryUsage() {
+			std::size_t threads = StartedThreads();
+			MemoryStats stats{ threads, threads * WorkerThread::StackSize(_stackSize), 0, 0, 0, 0 };
+			{
+				lock_type lock(_workMutex);
+				if (_queueArena) {
+					stats.arenaMappedBytes += _queueArena->Stats().mappedBytes;
+					stats.arenaAllocatedBytes += _queueArena->Stats().allocatedBytes;
+					stats.arenaTrimmedBytes += _queueArena->Stats().trimmedBytes;
+				}
+				stats.bookkeepingBytes += (_works.Size() + _ready.size()) * sizeof(WorkItem);
+			}
+			for (std::unique_ptr<ArenaUsage>& usage : _arenaUsage) {
+				stats.arenaMappedBytes += usage->mappedBytes.load(std::memory_order_relaxed);
+				stats.arenaAllocatedBytes += usage->allocatedBytes.load(std::memory_order_relaxed);
+				stats.arenaTrimmedBytes += usage->trimmedBytes.load(std::memory_order_relaxed);
+			}
+			stats.bookkeepingBytes += _batches.size() * (sizeof(WorkerBatch) + _maxDequeueBatch * sizeof(ReadyItem));
+			lock_type lock(_traceMutex);
+			for (std::unique_ptr<Trace::Ring>& ring : _traceRings) {
+				stats.bookkeepingBytes += ring->Bytes();
+			}
+			return stats;
+		}
+
+		// Starts recording tasks into per-worker rings holding the most recent eventsPerWorker tasks
+		// Ring capacity is fixed by the first call
+		void EnableTracing(std::size_t eventsPerWorker = DefaultTraceCapacity) {
+			lock_type lock(_traceMutex);
+			if (_traceRings.empty()) {
+				for (std::size_t i = 0; i < _maxThreads; ++i) {
+					_traceRings.emplace_back(new Trace::Ring(eventsPerWorker));
+				}
+			}
+			_tracing.store(true, std::memory_order_release);
+		}
+
+		void DisableTracing() {
+			_tracing.store(false, std::memory_order_release);
+		}
+
+		bool Tracing() const {
+			return _tracing.load(std::memory_order_acquire);
+		}
+
+		std::vector<Trace::Event> TraceEvents() {
+			lock_type lock(_traceMutex);
+			std::vector<Trace::Event> events;
+			for (std::size_t i = 0; i < _traceRings.size(); ++i) {
+				_traceRings[i]->Snapshot(i, events);
+			}
+			return events;
+		}
+
+		// Writes recorded tasks as Chrome Trace Event JSON, returns false if the file could not be written
+		bool DumpTrace(const std::string& path) {
+			return Trace::WriteChromeTrace(path, TraceEvents(), StartedThreads());
+		}
+
+		// Records wall and thread CPU time of every task by label, and with hardwareCounters the cycles, instructions and cache misses of workers allowed to open perf events
+		// Costs a few system calls per task, workers refused perf events (containers, perf_event_paranoid, non-Linux) still record times
+		void EnableProfiling(bool hardwareCounters = true) {
+			lock_type lock(_profileMutex);
+			if (_profiles.empty()) {
+				for (std::size_t i = 0; i < _maxThreads; ++i) {
+					_profiles.emplace_back(new Profile::Worker());
+				}
+			}
+			_profileCounters.store(hardwareCounters, std::memory_order_release);
+			_profiling.store(true, std::memory_order_release);
+		}
+
+		void DisableProfiling() {
+			_profiling.store(false, std::memory_order_release);
+		}
+
+		bool Profiling() const {
+			return _profiling.load(std::memory_order_acquire);
+		}
+
+		// Totals since profiling was first enabled or last reset, tasks still running are not included
+		Profile::Report ProfileResults() {
+			lock_type lock(_profileMutex);
+			return Profile::Collect(_profiles);
+		}
+
+		void ResetProfile() {
+			lock_type lock(_profileMutex);
+			for (std::unique_ptr<Profile::Worker>& profile : _profiles) {
+				profile->Reset();
+			}
+		}
+
+		// Runs one task at a time and records the order they were dequeued in, seed zero keeps queue order
+		// Tasks are numbered by submission, call Wait first and push from one thread or from tasks so numbering repeats
+		// A nonzero seed picks among the tasks queued when a worker looks, so the order only repeats when every task is queued while the threadpool is paused
+		// A task inside a BlockingScope gives up the slot until the scope ends
+		void StartRecording(std::uint64_t seed = 0) {
+			lock_type lock(_workMutex);
+			BeginDeterministic(seed);
+		}
+
+		// Runs tasks in a recorded order, if the next recorded task is not submitted within timeout the rest runs in seeded order
+		void StartReplay(Schedule schedule, std::chrono::milliseconds timeout = DefaultReplayTimeout) {
+			lock_type lock(_workMutex);
+			BeginDeterministic(schedule.seed);
+			_replay = std::move(schedule);
+			_replaying = true;
+			_replayTimeout = timeout;
+		}
+
+		// Returns to normal scheduling, the result is the order tasks actually ran in and can be saved or replayed
+		Schedule StopDeterministic() {
+			Schedule recorded;
+			{
+				lock_type lock(_workMutex);
+				_deterministic.store(false, std::memory_order_release);
+				_replaying = false;
+				recorded = std::move(_recorded);
+				_recorded = Schedule();
+				_deterministicVariable.notify_all();
+			}
+			WakeAll();
+			return recorded;
+		}
+
+		bool Deterministic() const {
+			return _deterministic.load(std::memory_order_acquire);
+		}
+
+		static WorkerContext& CurrentWorker() {
+			thread_local WorkerContext context{ nullptr, 0, 0, false, 0 };
+			return context;
+		}
+
+		// Scratch for the running task from the calling worker's arena, falls back to operator new outside workers or without hugePageArena
+		// Free the memory on the same worker before the task returns
+		template <class _ValueTy = unsigned char>
+		static ArenaAllocator<_ValueTy> ScratchAllocator() {
+			WorkerContext& context = CurrentWorker();
+			if (context.threadpool == nullptr || context.threadpool->_workerArenas.empty()) {
+				return ArenaAllocator<_ValueTy>();
+			}
+			return ArenaAllocator<_ValueTy>(context.threadpool->_workerArenas[context.index].get());
+		}
+
+		// Queue arena only, worker arenas are private to their workers, zeroed without hugePageArena
+		ArenaStats GetArenaStats() {
+			lock_type lock(_workMutex);
+			return _queueArena ? _queueArena->Stats() : ArenaStats{ 0, 0, 0, 0, 0, 0 };
+		}
+
+		// Called by BlockingScope, lets another worker take work while the calling worker blocks
+		void EnterBlocking() {
+			if (CurrentWorker().serialized) {
+				lock_type lock(_workMutex);
+				_serialBusy = false;
+				_deterministicVariable.notify_all();
+			}
+			std::size_t eligible = _activeThreads.load(std::memory_order_acquire) + _blockedThreads.fetch_add(1, std::memory_order_acq_rel) + 1;
+			{
+				lock_type lock(_threadsMutex);
+				if (eligible > _startedThreads.load(std::memory_order_acquire) && _startedThreads.load(std::memory_order_acquire) < _maxThreads && _run) {
+					StartThread();
+				}
+			}
+			{
+				// Parked workers check their predicate under this lock, taking it orders the increment before their wait
+				lock_type lock(_sleepMutex);
+			}
+			_parkVariable.notify_all();
+		}
+
+		void LeaveBlocking() {
+			// The highest eligible worker parks once its current task completes
+			_blockedThreads.fetch_sub(1, std::memory_order_acq_rel);
+			WorkerContext& context = CurrentWorker();
+			if (context.serialized) {
+				lock_type lock(_workMutex);
+				_deterministicVariable.wait(lock, [this]() { return !_serialBusy || !_deterministic.load(std::memory_order_acquire) || !_run.load(std::memory_order_acquire); });
+				context.serialized = _deterministic.load(std::memory_order_acquire);
+				_serialBusy = _serialBusy || context.serialized;
+			}
+		}
+
 private:
-		void FunctionWrapper() {
+		// Caller must hold _threadsMutex or be the constructor
+		// The slot is counted before the thread exists, so Idle never sees a new worker waiting while the started count leaves out a busy one
+		void StartThread() {
+			std::size_t index = _threads.size();
+			_startedThreads.store(index + 1, std::memory_order_release);
+			try {
+				_threads.push_back(thread_type(_stackSize, &ThreadPoolCPP::FunctionWrapper, this, index));
+			} catch (...) {
+				{
+					lock_type lock(_sleepMutex);
+					_startedThreads.store(index, std::memory_order_release);
+				}
+				// Shutdown may be waiting for the slot's worker to exit
+				_exitVariable.notify_all();
+				throw;
+			}
+			if (_affinity[index] >= 0) {
+				_threads[index].SetAffinity(_affinity[index]);
+			}
+		}
+
+		void Enqueue(TenantId tenant, WorkItem item) {
+			lock_type lock(_workMutex);
+			CheckTenant(tenant);
+			bool deterministic = _deterministic.load(std::memory_order_relaxed);
+			item.sequence = deterministic ? ++_sequence : 0;
+			_works.Push(tenant, std::move(item));
+			if (deterministic) {
+				// A replay may be waiting for exactly this task
+				_deterministicVariable.notify_all();
+			}
+			WakeOne();
+			if (_lazyStart && _waitingThreads.load(std::memory_order_relaxed) == 0) {
+				lock.unlock();
+				StartOnDemand();
+			}
+		}
+
+		// Caller holds _workMutex, throws std::out_of_range for an id CreateTenant did not return
+		void CheckTenant(TenantId tenant) const {
+			if (tenant >= _works.Tenants()) {
+				throw std::out_of_range("ThreadPoolCPP: unknown tenant");
+			}
+		}
+
+		void StartOnDemand() {
+			lock_type lock(_threadsMutex);
+			std::size_t started = _startedThreads.load(std::memory_order_acquire);
+			if (started < _activeThreads.load(std::memory_order_acquire) + _blockedThreads.load(std::memory_order_acquire) && started < _maxThreads && _run) {
+				StartThread();
+			}
+		}
+
+		// Lazy start only starts a worker for a push that finds none waiting
+		// Work pushed while this worker was waking found it waiting, so a worker about to run its tasks starts a helper for what is left
+		void StartHelper() {
+			if (_lazyStart && _waitingThreads.load(std::memory_order_relaxed) == 0 && (HasWork() || Stealable())) {
+				StartOnDemand();
+			}
+		}
+
+		bool Idle() const {
+			return _waitingThreads >= _startedThreads.load(std::memory_order_acquire) && _works.Empty() && _readyCount.load(std::memory_order_acquire) == 0;
+		}
+
+		bool HasWork() const {
+			return _works.Runnable() || _readyCount.load(std::memory_order_acquire) != 0;
+		}
+
+		// Caller holds _workMutex
+		void BeginDeterministic(std::uint64_t seed) {
+			_deterministic.store(true, std::memory_order_release);
+			_replaying = false;
+			_sequence = 0;
+			_scheduleState = seed;
+			_replayPosition = 0;
+			_replay = Schedule();
+			_recorded = Schedule();
+			_recorded.seed = seed;
+		}
+
+		// Caller holds lock on _workMutex, also drains what is left in _ready after the mode stops
+		bool PopDeterministic(lock_type& lock, std::size_t index, WorkItem& item, work_container::handle_type& tenant) {
+			for (;;) {
+				if (!_run.load(std::memory_order_acquire)) {
+					return false;
+				}
+				ReadyItem ready;
+				while (_works.Pop(ready.item, ready.tenant)) {
+					_ready.push_back(std::move(ready));
+					_readyCount.fetch_add(1, std::memory_order_release);
+				}
+				if (_ready.empty()) {
+					return false;
+				}
+				bool deterministic = _deterministic.load(std::memory_order_acquire);
+				if (deterministic && _serialBusy) {
+					_deterministicVariable.wait(lock);
+					continue;
+				}
+				std::size_t position = 0;
+				if (deterministic && _replaying) {
+					if (_replayPosition == _replay.entries.size()) {
+						_replaying = false;
+						continue;
+					}
+					std::uint64_t sequence = _replay.entries[_replayPosition].sequence;
+					while (position < _ready.size() && _ready[position].item.sequence != sequence) {
+						++position;
+					}
+					if (position == _ready.size()) {
+						// Not submitted yet, every Push notifies so the timeout only expires once submissions stop
+						if (_deterministicVariable.wait_for(lock, _replayTimeout) == std::cv_status::timeout) {
+							_recorded.diverged = true;
+							_replaying = false;
+						}
+						continue;
+					}
+					++_replayPosition;
+				} else if (deterministic && _recorded.seed != 0) {
+					position = (std::size_t)(NextScheduleRandom(_scheduleState) % _ready.size());
+				}
+
+				item = std::move(_ready[position].item);
+				tenant = _ready[position].tenant;
+				_ready.erase(_ready.begin() + (std::ptrdiff_t)position);
+				_readyCount.fetch_sub(1, std::memory_order_release);
+				if (deterministic) {
+					_serialBusy = true;
+					CurrentWorker().serialized = true;
+					_recorded.entries.push_back(ScheduleEntry{ item.sequence, index });
+				}
+				return true;
+			}
+		}
+
+		// Removes every queued task and counts it in report
+		void Drop(ShutdownReport& report) {
+			{
+				lock_type lock(_workMutex);
+				_deterministic.store(false, std::memory_order_release);
+				_deterministicVariable.notify_all();
+				WorkItem item;
+				work_container::handle_type tenant;
+				while (_works.Pop(item, tenant)) {
+					_ready.push_back(ReadyItem{ std::move(item), tenant });
+				}
+				for (ReadyItem& ready : _ready) {
+					// Batch tasks are not reported, the trivial tasks they would have run are counted below
+					if (!ready.item.coalesced) {
+						++report.dropped;
+						if (ready.item.label != nullptr) {
+							report.droppedLabels.push_back(ready.item.label);
+						}
+					}
+					_works.Cancel(ready.tenant);
+				}
+				_ready.clear();
+				_readyCount.store(0, std::memory_order_release);
+			}
+			{
+				lock_type lock(_batchMutex);
+				report.dropped += _batch.size();
+				_batch.clear();
+			}
+		}
+
+		// Caller holds _workMutex, fills the worker's batch with a share of the queue sized so that every eligible worker gets some
+		bool PopBatch(WorkerBatch& batch) {
+			std::size_t workers = _activeThreads.load(std::memory_order_acquire) + _blockedThreads.load(std::memory_order_acquire);
+			std::size_t count = _works.Size() / (workers ? workers : 1);
+			count = count < 1 ? 1 : (count > _maxDequeueBatch ? _maxDequeueBatch : count);
+			std::size_t size = 0;
+			while (size < count && _works.Pop(batch.items[size].item, batch.items[size].tenant)) {
+				++size;
+			}
+			if (size == 0) {
+				return false;
+			}
+			batch.taken.store(0, std::memory_order_relaxed);
+			// Publishing before WakeOne reads _waitingThreads pairs with the fence of a worker going to sleep
+			batch.state.store(size, std::memory_order_seq_cst);
+			return true;
+		}
+
+		// Owner and thieves alike, the claimed slot belongs to the caller until its task is moved out
+		static bool Claim(WorkerBatch& batch, ReadyItem& ready) {
+			std::uint64_t state = batch.state.load(std::memory_order_acquire);
+			do {
+				if ((state >> 32) >= (state & 0xFFFFFFFF)) {
+					return false;
+				}
+			} while (!batch.state.compare_exchange_weak(state, state + (1ull << 32), std::memory_order_acq_rel, std::memory_order_acquire));
+			ready = std::move(batch.items[state >> 32]);
+			batch.taken.fetch_add(1, std::memory_order_release);
+			return true;
+		}
+
+		// A thief may still be moving a task out of the last batch, the owner waits for it before refilling
+		static void WaitTaken(WorkerBatch& batch) {
+			while (batch.taken.load(std::memory_order_acquire) != (batch.state.load(std::memory_order_relaxed) & 0xFFFFFFFF)) {
+				std::this_thread::yield();
+			}
+		}
+
+		// Slots of every batch not claimed yet, a snapshot that may be stale by the time it returns
+		std::size_t BatchedTasks() const {
+			std::size_t batched = 0;
+			std::size_t started = _startedThreads.load(std::memory_order_acquire);
+			for (std::size_t i = 0; i < started; ++i) {
+				std::uint64_t state = _batches[i]->state.load(std::memory_order_relaxed);
+				batched += (state >> 32) < (state & 0xFFFFFFFF) ? (std::size_t)((state & 0xFFFFFFFF) - (state >> 32)) : 0;
+			}
+			return batched;
+		}
+
+		bool Stealable() const {
+			std::size_t started = _startedThreads.load(std::memory_order_acquire);
+			for (std::size_t i = 0; i < started; ++i) {
+				std::uint64_t state = _batches[i]->state.load(std::memory_order_relaxed);
+				if ((state >> 32) < (state & 0xFFFFFFFF)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Takes one task from another worker's batch, so a long task does not hold up the ones taken with it
+		bool Steal(std::size_t index, ReadyItem& ready) {
+			if (_deterministic.load(std::memory_order_acquire)) {
+				return false;
+			}
+			std::size_t started = _startedThreads.load(std::memory_order_acquire);
+			for (std::size_t i = 1; i < started; ++i) {
+				if (Claim(*_batches[(index + i) % started], ready)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Whether the owner must hand the rest of its batch back, checked between tasks
+		bool YieldBatch(std::size_t index) const {
+			return !_run.load(std::memory_order_acquire) || _pause.load(std::memory_order_acquire) || !Eligible(index) || _deterministic.load(std::memory_order_acquire);
+		}
+
+		void ReturnBatch(WorkerBatch& batch) {
+			std::vector<ReadyItem> rest;
+			ReadyItem ready;
+			while (Claim(batch, ready)) {
+				rest.push_back(std::move(ready));
+			}
+			if (rest.empty()) {
+				return;
+			}
+			{
+				lock_type lock(_workMutex);
+				for (std::size_t i = rest.size(); i-- > 0;) {
+					_works.Return(rest[i].tenant, std::move(rest[i].item));
+				}
+			}
+			WakeOne();
+		}
+
+		bool Eligible(std::size_t index) const {
+			return index < _activeThreads.load(std::memory_order_acquire) + _blockedThreads.load(std::memory_order_acquire);
+		}
+
+		void FunctionWrapper(std::size_t index) {
+			WorkerContext& context = CurrentWorker();
+			context = WorkerContext{ this, index, 0, false, 0 };
+			WorkerBatch& batch = *_batches[index];
+			// Set once the worker ran tasks since its last trim, a trim is due when it then stays idle for _idleTrim
+			bool untrimmed = false;
 			while (_run) {
+				bool trim = false;
 				// Sleep thread
 				{
 					lock_type lock(_sleepMutex);
+					// The increment is a seq_cst read-modify-write, which is all WaitingThreads needs under ThreadSanitizer
 					++_waitingThreads;
-					_conditionVariable.wait(lock);
+#if !THREADPOOL_TSAN
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+					if (!Eligible(index)) {
+						_parkVariable.wait(lock, [this, index]() { return !_run || Eligible(index); });
+					} else if (((!HasWork() && !Stealable()) || _pause) && _run) {
+						// Spare workers start with work already queued, they must not wait for a Wake that was already issued
+						if (untrimmed && !_workerArenas.empty() && _idleTrim.count() != 0) {
+							trim = _conditionVariable.wait_for(lock, _idleTrim) == std::cv_status::timeout;
+						} else {
+							_conditionVariable.wait(lock);
+						}
+					}
 					--_waitingThreads;
 				}
+				if (trim) {
+					TrimIdle(index);
+					untrimmed = false;
+					continue;
+				}
+				untrimmed = true;
 
 				// Loop work execution
-				while (!_works.empty() && !_pause) {
+				while (_run.load(std::memory_order_acquire) && !_pause && Eligible(index)) {
+					if (!HasWork()) {
+						// Nothing queued, help a worker whose batch still holds tasks
+						ReadyItem stolen;
+						if (!Steal(index, stolen)) {
+							break;
+						}
+						Run(index, context, stolen);
+						continue;
+					}
+					WaitTaken(batch);
 					// Acquire lock and ensure there is work to be done
 					lock_type lock(_workMutex);
-					if (_works.empty()) {
+					_dequeueLocks.fetch_add(1, std::memory_order_relaxed);
+					if (_deterministic.load(std::memory_order_relaxed) || _readyCount.load(std::memory_order_relaxed) != 0) {
+						ReadyItem ready;
+						if (!PopDeterministic(lock, index, ready.item, ready.tenant)) {
+							break;
+						}
+						lock.unlock();
+						Run(index, context, ready);
+						continue;
+					}
+					if (!PopBatch(batch)) {
 						break;
 					}
-					auto work(_works.front());
-					_works.pop();
 					lock.unlock();
-					
-					work();
+					if ((batch.state.load(std::memory_order_relaxed) & 0xFFFFFFFF) > 1) {
+						// Idle workers can take part of the batch
+						WakeOne();
+					}
+					StartHelper();
+
+					for (;;) {
+						ReadyItem ready;
+						if (!Claim(batch, ready)) {
+							break;
+						}
+						Run(index, context, ready);
+						if (YieldBatch(index)) {
+							ReturnBatch(batch);
+							break;
+						}
+					}
+				}
+			}
+			{
+				lock_type lock(_sleepMutex);
+				++_exitedThreads;
+			}
+			_exitVariable.notify_all();
+		}
+
+		// Runs on the worker owning the arena, the queue arena is skipped when pushes hold the lock or tasks are queued
+		void TrimIdle(std::size_t index) {
+			_workerArenas[index]->Trim();
+			PublishArena(index);
+			lock_type lock(_workMutex, std::try_to_lock);
+			if (lock && _queueArena && _works.Empty()) {
+				_queueArena->Trim();
+			}
+		}
+
+		void PublishArena(std::size_t index) {
+			ArenaStats stats = _workerArenas[index]->Stats();
+			_arenaUsage[index]->mappedBytes.store(stats.mappedBytes, std::memory_order_relaxed);
+			_arenaUsage[index]->allocatedBytes.store(stats.allocatedBytes, std::memory_order_relaxed);
+			_arenaUsage[index]->trimmedBytes.store(stats.trimmedBytes, std::memory_order_relaxed);
+		}
+
+		void Run(std::size_t index, WorkerContext& context, ReadyItem& ready) {
+			if (ready.item.deadline != deadline_type() && std::chrono::steady_clock::now() > ready.item.deadline) {
+				Expire(ready);
+			} else {
+				if (_tracing.load(std::memory_order_acquire) || _profiling.load(std::memory_order_acquire)) {
+					ExecuteTraced(index, ready.item);
+				} else {
+					ready.item.work();
+				}
+				Complete(ready.tenant);
+				// A batch task counts the trivial tasks it ran instead of itself
+				if (!ready.item.coalesced) {
+					_completedTasks.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			if (!_workerArenas.empty()) {
+				PublishArena(index);
+			}
+			if (context.serialized) {
+				lock_type lock(_workMutex);
+				context.serialized = false;
+				_serialBusy = false;
+				_deterministicVariable.notify_all();
+			}
+		}
+
+		void Expire(ReadyItem& ready) {
+			{
+				lock_type lock(_workMutex);
+				_works.Cancel(ready.tenant);
+				if (work_container::Capped(ready.tenant)) {
+					WakeOne();
+				}
+			}
+			_expiredTasks.fetch_add(1, std::memory_order_relaxed);
+			if (ready.item.expired) {
+				(*ready.item.expired)();
+			}
+		}
+
+		void Complete(work_container::handle_type tenant) {
+			if (!work_container::Capped(tenant)) {
+				_works.Complete(tenant);
+				return;
+			}
+			// A capped tenant may have become runnable, this worker rechecks but another can start in parallel
+			lock_type lock(_workMutex);
+			if (_works.Complete(tenant)) {
+				WakeOne();
+			}
+		}
+
+		// Batch task queued by PushTrivial, may find its run already taken by an earlier one
+		void RunBatch() {
+			std::vector<work_type> works;
+			{
+				lock_type lock(_batchMutex);
+				std::size_t count = _batch.size() < _coalesceLimit ? _batch.size() : _coalesceLimit;
+				works.reserve(count);
+				for (std::size_t i = 0; i < count; ++i) {
+					works.push_back(std::move(_batch.front()));
+					_batch.pop_front();
 				}
 			}
+			for (work_type& work : works) {
+				work();
+			}
+			if (!works.empty()) {
+				_completedTasks.fetch_add(works.size(), std::memory_order_relaxed);
+			}
+		}
+
+		// Tracing and profiling may be switched while the task runs, the rings and profiles then exist already
+		void ExecuteTraced(std::size_t index, WorkItem& item) {
+			Profile::Worker* profile = _profiling.load(std::memory_order_acquire) ? _profiles[index].get() : nullptr;
+			Profile::Worker::Sample sample = profile ? profile->Begin(_profileCounters.load(std::memory_order_acquire)) : Profile::Worker::Sample();
+			std::uint64_t startTime = Trace::Now();
+			item.work();
+			std::uint64_t endTime = Trace::Now();
+			if (profile) {
+				profile->End(item.label, sample);
+			}
+			if (_tracing.load(std::memory_order_acquire)) {
+				_traceRings[index]->Record(item.label, item.enqueueTime, startTime, endTime);
+			}
 		}
 
 		template <class _FuncTy, class..._ArgsTy>
@@ -113,4 +1222,28 @@ private:
 			std::invoke(functor, args...);
 		}
 	};
+
+	// RAII hint for tasks about to block (I/O, locks), a spare worker runs queued work until the scope ends
+	// Nested scopes count once and scopes outside a ThreadPoolCPP worker do nothing
+	class BlockingScope {
+	protected:
+		ThreadPoolCPP::WorkerContext* _context;
+	public:
+		BlockingScope() : _context(&ThreadPoolCPP::CurrentWorker()) {
+			if (_context->threadpool == nullptr) {
+				_context = nullptr;
+			} else if (_context->blockingDepth++ == 0) {
+				_context->threadpool->EnterBlocking();
+			}
+		}
+
+		BlockingScope(const BlockingScope&) = delete;
+		BlockingScope& operator=(const BlockingScope&) = delete;
+
+		~BlockingScope() {
+			if (_context != nullptr && --_context->blockingDepth == 0) {
+				_context->threadpool->LeaveBlocking();
+			}
+		}
+	};
 }
\ No newline at end of file
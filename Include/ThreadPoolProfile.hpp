@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ThreadPoolTrace.hpp"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <ctime>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Threading {
+	namespace Profile {
+		// Nanoseconds the calling thread spent on a processor, in user and kernel mode
+		inline std::uint64_t ThreadCpuTime() {
+#if defined(_WIN32)
+			FILETIME creation, exit, kernel, user;
+			if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+				return 0;
+			}
+			std::uint64_t ticks = ((std::uint64_t)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) + ((std::uint64_t)user.dwHighDateTime << 32 | user.dwLowDateTime);
+			// FILETIME counts 100 ns ticks
+			return ticks * 100;
+#else
+			timespec time;
+			if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+				return 0;
+			}
+			return (std::uint64_t)time.tv_sec * 1000000000 + (std::uint64_t)time.tv_nsec;
+#endif
+		}
+
+		struct LabelStats {
+			std::string label;
+			std::uint64_t tasks;
+			std::uint64_t wallNanoseconds;
+			// Below wallNanoseconds when the task blocked or was descheduled
+			std::uint64_t cpuNanoseconds;
+			// Tasks that ran on a worker with hardware counters, the counters below cover only those
+			std::uint64_t countedTasks;
+			std::uint64_t cycles;
+			std::uint64_t instructions;
+			std::uint64_t cacheMisses;
+		};
+
+		struct Report {
+			// One entry per label, most CPU time first, unlabelled tasks are reported as "Task"
+			std::vector<LabelStats> labels;
+			// Workers that opened hardware counters and workers that were refused them
+			std::size_t countedWorkers;
+			std::size_t uncountedWorkers;
+			// errno of the last refusal, e.g. EACCES under perf_event_paranoid or ENOENT without a PMU, zero if none
+			int counterError;
+		};
+
+		// Cycles, instructions and cache misses of the thread that opened them, user mode only
+		// Linux perf events read as one group, elsewhere Open fails with ENOSYS
+		class Counters {
+		public:
+			static constexpr std::size_t Count = 3;
+		protected:
+			int _descriptors[Count];
+			int _error;
+		public:
+			Counters() : _error(0) {
+				std::fill(_descriptors, _descriptors + Count, -1);
+			}
+
+			Counters(const Counters&) = delete;
+			Counters& operator=(const Counters&) = delete;
+
+			~Counters() {
+				Close();
+			}
+
+			// Must run on the thread to be counted, false leaves the counters closed and sets Error
+			bool Open() {
+#if defined(__linux__)
+				const std::uint64_t events[Count] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+				for (std::size_t i = 0; i < Count; ++i) {
+					perf_event_attr attributes;
+					std::memset(&attributes, 0, sizeof(attributes));
+					attributes.type = PERF_TYPE_HARDWARE;
+					attributes.size = sizeof(attributes);
+					attributes.config = events[i];
+					attributes.read_format = PERF_FORMAT_GROUP;
+					attributes.exclude_kernel = 1;
+					attributes.exclude_hv = 1;
+					_descriptors[i] = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, i ? _descriptors[0] : -1, 0);
+					if (_descriptors[i] < 0) {
+						_error = errno;
+						Close();
+						return false;
+					}
+				}
+				return true;
+#else
+				_error = ENOSYS;
+				return false;
+#endif
+			}
+
+			bool Opened() const {
+				return _descriptors[0] >= 0;
+			}
+
+			int Error() const {
+				return _error;
+			}
+
+			// Running totals since Open, false if the counters are closed or the read failed
+			bool Read(std::uint64_t values[Count]) const {
+#if defined(__linux__)
+				if (!Opened()) {
+					return false;
+				}
+				std::uint64_t group[1 + Count];
+				if (read(_descriptors[0], group, sizeof(group)) != (ssize_t)sizeof(group) || group[0] != Count) {
+					return false;
+				}
+				std::copy(group + 1, group + 1 + Count, values);
+				return true;
+#else
+				(void)values;
+				return false;
+#endif
+			}
+		private:
+			void Close() {
+				for (std::size_t i = Count; i-- > 0;) {
+#if !defined(_WIN32)
+					if (_descriptors[i] >= 0) {
+						close(_descriptors[i]);
+					}
+#endif
+					_descriptors[i] = -1;
+				}
+			}
+		};
+
+		// Totals per label for one worker, written by that worker and read under the mutex by Snapshot
+		// Tasks are keyed by label address, Snapshot merges equal labels from different addresses
+		class Worker {
+		public:
+			struct Sample {
+				std::uint64_t wallTime;
+				std::uint64_t cpuTime;
+				std::uint64_t counters[Counters::Count];
+				bool counted;
+			};
+		protected:
+			std::mutex _mutex;
+			std::unordered_map<const char*, LabelStats> _labels;
+			Counters _counters;
+			// Set by the worker once it tried to open the counters, they are not touched again afterwards
+			std::atomic_bool _attempted;
+		public:
+			Worker() : _attempted(false) {
+
+			}
+
+			// Opens the counters on first use, perf events follow the thread that opened them
+			Sample Begin(bool hardwareCounters) {
+				Sample sample;
+				if (hardwareCounters && !_attempted.load(std::memory_order_relaxed)) {
+					_counters.Open();
+					_attempted.store(true, std::memory_order_release);
+				}
+				sample.counted = hardwareCounters && _counters.Read(sample.counters);
+				sample.cpuTime = ThreadCpuTime();
+				sample.wallTime = Trace::Now();
+				return sample;
+			}
+
+			void End(const char* label, const Sample& start) {
+				Sample end;
+				end.wallTime = Trace::Now();
+				end.cpuTime = ThreadCpuTime();
+				end.counted = start.counted && _counters.Read(end.counters);
+				std::lock_guard<std::mutex> lock(_mutex);
+				LabelStats& stats = _labels[label];
+				stats.tasks += 1;
+				stats.wallNanoseconds += end.wallTime - start.wallTime;
+				stats.cpuNanoseconds += end.cpuTime > start.cpuTime ? end.cpuTime - start.cpuTime : 0;
+				if (end.counted) {
+					stats.countedTasks += 1;
+					stats.cycles += end.counters[0] - start.counters[0];
+					stats.instructions += end.counters[1] - start.counters[1];
+					stats.cacheMisses += end.counters[2] - start.counters[2];
+				}
+			}
+
+			void Snapshot(std::map<std::string, LabelStats>& labels, Report& report) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				for (const std::pair<const char* const, LabelStats>& entry : _labels) {
+					std::string label = entry.first ? entry.first : "Task";
+					LabelStats& stats = labels.emplace(label, LabelStats{ label, 0, 0, 0, 0, 0, 0, 0 }).first->second;
+					stats.tasks += entry.second.tasks;
+					stats.wallNanoseconds += entry.second.wallNanoseconds;
+					stats.cpuNanoseconds += entry.second.cpuNanoseconds;
+					stats.countedTasks += entry.second.countedTasks;
+					stats.cycles += entry.second.cycles;
+					stats.instructions += entry.second.instructions;
+					stats.cacheMisses += entry.second.cacheMisses;
+				}
+				if (!_attempted.load(std::memory_order_acquire)) {
+					return;
+				}
+				if (_counters.Opened()) {
+					report.countedWorkers += 1;
+				} else {
+					report.uncountedWorkers += 1;
+					report.counterError = _counters.Error();
+				}
+			}
+
+			void Reset() {
+				std::lock_guard<std::mutex> lock(_mutex);
+				_labels.clear();
+			}
+		};
+
+		// Merges worker totals by label, most CPU time first
+		inline Report Collect(std::vector<std::unique_ptr<Worker>>& workers) {
+			Report report{ {}, 0, 0, 0 };
+			std::map<std::string, LabelStats> labels;
+			for (std::unique_ptr<Worker>& worker : workers) {
+				worker->Snapshot(labels, report);
+			}
+			for (std::pair<const std::string, LabelStats>& entry : labels) {
+				report.labels.push_back(entry.second);
+			}
+			std::stable_sort(report.labels.begin(), report.labels.end(), [](const LabelStats& left, const LabelStats& right) { return left.cpuNanoseconds > right.cpuNanoseconds; });
+			return report;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ThreadSanitizer.hpp"
+
+namespace Threading {
+	namespace Trace {
+		using clock_type = std::chrono::steady_clock;
+
+		// Nanoseconds since the clock epoch, zero is reserved for "not recorded"
+		inline std::uint64_t Now() {
+			return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+		}
+
+		struct Event {
+			const char* label;
+			std::uint64_t enqueueTime;
+			std::uint64_t startTime;
+			std::uint64_t endTime;
+			std::size_t worker;
+		};
+
+		// Fixed size ring written by a single worker, the oldest events are overwritten when full
+		// Readers may run concurrently, each slot is guarded by a sequence number so torn events are skipped
+		class Ring {
+		protected:
+			struct Slot {
+				std::atomic_uint64_t sequence;
+				std::atomic<const char*> label;
+				std::atomic_uint64_t enqueueTime;
+				std::atomic_uint64_t startTime;
+				std::atomic_uint64_t endTime;
+
+				Slot() : sequence(0), label(nullptr), enqueueTime(0), startTime(0), endTime(0) {
+
+				}
+			};
+
+			std::unique_ptr<Slot[]> _slots;
+			std::size_t _mask;
+			std::atomic_uint64_t _written;
+
+#if THREADPOOL_TSAN
+			// ThreadSanitizer does not model fences, release stores and acquire loads of the fields order a slot the same way
+			static constexpr std::memory_order StoreOrder = std::memory_order_release;
+			static constexpr std::memory_order LoadOrder = std::memory_order_acquire;
+
+			static void Fence(std::memory_order) {
+
+			}
+#else
+			static constexpr std::memory_order StoreOrder = std::memory_order_relaxed;
+			static constexpr std::memory_order LoadOrder = std::memory_order_relaxed;
+
+			static void Fence(std::memory_order order) {
+				std::atomic_thread_fence(order);
+			}
+#endif
+		public:
+			// Capacity is rounded up to a power of two
+			Ring(std::size_t capacity) : _mask(0), _written(0) {
+				std::size_t size = 1;
+				while (size < capacity) {
+					size <<= 1;
+				}
+				_slots.reset(new Slot[size]);
+				_mask = size - 1;
+			}
+
+			void Record(const char* label, std::uint64_t enqueueTime, std::uint64_t startTime, std::uint64_t endTime) {
+				std::uint64_t index = _written.load(std::memory_order_relaxed);
+				Slot& slot = _slots[index & _mask];
+				slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+				Fence(std::memory_order_release);
+				slot.label.store(label, StoreOrder);
+				slot.enqueueTime.store(enqueueTime, StoreOrder);
+				slot.startTime.store(startTime, StoreOrder);
+				slot.endTime.store(endTime, StoreOrder);
+				slot.sequence.store(2 * index + 2, std::memory_order_release);
+				_written.store(index + 1, std::memory_order_release);
+			}
+
+			std::size_t Capacity() const {
+				return _mask + 1;
+			}
+
+			// Memory held by the slots
+			std::size_t Bytes() const {
+				return Capacity() * sizeof(Slot);
+			}
+
+			std::uint64_t Written() const {
+				return _written.load(std::memory_order_acquire);
+			}
+
+			// Appends the events still held by the ring, oldest first
+			void Snapshot(std::size_t worker, std::vector<Event>& events) const {
+				std::uint64_t written = Written();
+				std::uint64_t first = written > Capacity() ? written - Capacity() : 0;
+				for (std::uint64_t index = first; index < written; ++index) {
+					const Slot& slot = _slots[index & _mask];
+					std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+					Event event{ slot.label.load(LoadOrder), slot.enqueueTime.load(LoadOrder), slot.startTime.load(LoadOrder), slot.endTime.load(LoadOrder), worker };
+					Fence(std::memory_order_acquire);
+					if (sequence != 2 * index + 2 || slot.sequence.load(std::memory_order_relaxed) != sequence) {
+						continue;
+					}
+					events.push_back(event);
+				}
+			}
+		};
+
+		inline void WriteEscaped(std::ostream& stream, const char* text) {
+			for (; *text; ++text) {
+				switch (*text) {
+				case '"':
+					stream << "\\\"";
+					break;
+				case '\\':
+					stream << "\\\\";
+					break;
+				case '\n':
+					stream << "\\n";
+					break;
+				default:
+					if ((unsigned char)*text < 0x20) {
+						stream << ' ';
+					} else {
+						stream << *text;
+					}
+				}
+			}
+		}
+
+		// Chrome Trace Event format, loadable by chrome://tracing and Perfetto
+		// Each task is a complete event on its worker's track, queueing delay is carried in args
+		inline bool WriteChromeTrace(const std::string& path, const std::vector<Event>& events, std::size_t numberWorkers) {
+			std::ofstream stream(path, std::ios::out | std::ios::trunc);
+			if (!stream) {
+				return false;
+			}
+			std::uint64_t epoch = 0;
+			for (const Event& event : events) {
+				std::uint64_t first = event.enqueueTime ? event.enqueueTime : event.startTime;
+				if (epoch == 0 || first < epoch) {
+					epoch = first;
+				}
+			}
+
+			stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+			stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"ThreadPool\"}}";
+			for (std::size_t i = 0; i < numberWorkers; ++i) {
+				stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"Worker " << i << "\"}}";
+			}
+			stream.precision(3);
+			stream << std::fixed;
+			for (const Event& event : events) {
+				std::uint64_t enqueueTime = event.enqueueTime ? event.enqueueTime : event.startTime;
+				stream << ",\n{\"name\":\"";
+				WriteEscaped(stream, event.label ? event.label : "Task");
+				stream << "\",\"cat\":\"task\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.worker;
+				stream << ",\"ts\":" << (event.startTime - epoch) / 1000.0;
+				stream << ",\"dur\":" << (event.endTime - event.startTime) / 1000.0;
+				stream << ",\"args\":{\"enqueue_us\":" << (enqueueTime - epoch) / 1000.0;
+				stream << ",\"queued_us\":" << (event.startTime - enqueueTime) / 1000.0 << "}}";
+			}
+			stream << "\n]}\n";
+			return (bool)stream;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+// THREADPOOL_TSAN is 1 when building under ThreadSanitizer, which does not model std::atomic_thread_fence
+// Headers that synchronise through a fence use a read-modify-write or acquire/release accesses instead when it is set
+// GCC and Clang 20 or later define __SANITIZE_THREAD__, older Clang only reports it through __has_feature
+#if defined(__SANITIZE_THREAD__)
+#define THREADPOOL_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define THREADPOOL_TSAN 1
+#endif
+#endif
+
+#ifndef THREADPOOL_TSAN
+#define THREADPOOL_TSAN 0
+#endif
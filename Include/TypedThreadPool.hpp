@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace Threading {
+	// Threadpool for a single task type, arguments are stored contiguously in a bounded ring and passed straight to _FuncTy
+	// No std::function, no per-task allocation, use a functor or lambda type rather than a function pointer so calls can inline
+	// The functor is shared by every worker and must be safe to call concurrently
+	template <class _FuncTy, class..._ArgsTy>
+	class TypedThreadPool {
+	public:
+		using function_type = _FuncTy;
+		using args_type = std::tuple<_ArgsTy...>;
+		using thread_type = std::thread;
+		using thread_container = std::vector<thread_type>;
+		using lock_type = std::unique_lock<std::mutex>;
+
+		static constexpr std::size_t DefaultCapacity = 1 << 12;
+		// Idle workers poll this many times before sleeping
+		static constexpr std::size_t SpinCount = 64;
+	protected:
+		// Bounded multi-producer multi-consumer queue (Vyukov), a slot's sequence tells producers and consumers whose turn it is
+		struct alignas(64) Slot {
+			std::atomic_size_t sequence;
+			alignas(args_type) unsigned char storage[sizeof(args_type)];
+
+			args_type* Args() {
+				return std::launder(reinterpret_cast<args_type*>(storage));
+			}
+		};
+
+		function_type _functor;
+		std::unique_ptr<Slot[]> _slots;
+		std::size_t _mask;
+		alignas(64) std::atomic_size_t _enqueuePosition;
+		alignas(64) std::atomic_size_t _dequeuePosition;
+		alignas(64) std::atomic_size_t _pending;
+		std::atomic_size_t _sleepingThreads;
+		std::atomic_bool _run;
+		std::atomic_bool _pause;
+		std::mutex _sleepMutex;
+		std::condition_variable _conditionVariable;
+		thread_container _threads;
+	public:
+		// Capacity is rounded up to a power of two, Push blocks while the ring is full
+		TypedThreadPool(std::size_t numberThreads, function_type functor = function_type(), std::size_t capacity = DefaultCapacity) : _functor(std::move(functor)), _mask(0), _enqueuePosition(0), _dequeuePosition(0), _pending(0), _sleepingThreads(0), _run(true), _pause(false) {
+			std::size_t size = 2;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			_slots.reset(new Slot[size]);
+			_mask = size - 1;
+			for (std::size_t i = 0; i < size; ++i) {
+				_slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			for (std::size_t i = 0; i < numberThreads; ++i) {
+				_threads.push_back(thread_type(&TypedThreadPool::FunctionWrapper, this));
+			}
+		}
+
+		TypedThreadPool(const TypedThreadPool&) = delete;
+		TypedThreadPool& operator=(const TypedThreadPool&) = delete;
+
+		// Runs every queued task before joining
+		~TypedThreadPool() {
+			Resume();
+			Wait();
+			Stop();
+			for (thread_type& t : _threads) {
+				if (t.joinable()) {
+					t.join();
+				}
+			}
+			// Only reachable with no workers, destroy arguments that were never consumed
+			while (TryDequeueDiscard()) {
+
+			}
+		}
+
+		template <class..._PushArgsTy>
+		bool TryPush(_PushArgsTy&&...args) {
+			std::size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+			for (;;) {
+				Slot& slot = _slots[position & _mask];
+				std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+				if (difference == 0) {
+					// Sequentially consistent so a sleeping worker's recheck cannot miss this claim
+					if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+						_pending.fetch_add(1, std::memory_order_relaxed);
+						new (slot.storage) args_type(std::forward<_PushArgsTy>(args)...);
+						slot.sequence.store(position + 1, std::memory_order_release);
+						WakeOne();
+						return true;
+					}
+				} else if (difference < 0) {
+					return false;
+				} else {
+					position = _enqueuePosition.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		template <class..._PushArgsTy>
+		void Push(_PushArgsTy&&...args) {
+			// Arguments are only consumed by a successful TryPush
+			while (!TryPush(std::forward<_PushArgsTy>(args)...)) {
+				std::this_thread::yield();
+			}
+		}
+
+		void Wait() {
+			while (_pending.load(std::memory_order_acquire) != 0 && !(_pause.load(std::memory_order_acquire) || _threads.empty())) {
+				std::this_thread::yield();
+			}
+		}
+
+		void Stop() {
+			{
+				lock_type lock(_sleepMutex);
+				_run.store(false, std::memory_order_release);
+			}
+			_conditionVariable.notify_all();
+		}
+
+		void Pause() {
+			_pause.store(true, std::memory_order_release);
+		}
+
+		void Resume() {
+			{
+				lock_type lock(_sleepMutex);
+				_pause.store(false, std::memory_order_release);
+			}
+			_conditionVariable.notify_all();
+		}
+
+		std::size_t Capacity() const {
+			return _mask + 1;
+		}
+
+		std::size_t Size() const {
+			return _threads.size();
+		}
+	private:
+		void WakeOne() {
+			if (_sleepingThreads.load(std::memory_order_seq_cst) != 0) {
+				lock_type lock(_sleepMutex);
+				_conditionVariable.notify_one();
+			}
+		}
+
+		// Returns false if the ring is empty
+		template <class _ConsumeTy>
+		bool TryDequeue(_ConsumeTy consume) {
+			std::size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+			for (;;) {
+				Slot& slot = _slots[position & _mask];
+				std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+				if (difference == 0) {
+					if (_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						args_type args(std::move(*slot.Args()));
+						slot.Args()->~args_type();
+						slot.sequence.store(position + _mask + 1, std::memory_order_release);
+						consume(args);
+						return true;
+					}
+				} else if (difference < 0) {
+					return false;
+				} else {
+					position = _dequeuePosition.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		bool TryDequeueDiscard() {
+			return TryDequeue([](args_type&) {});
+		}
+
+		bool Idle() const {
+			return _pause.load(std::memory_order_acquire) || _enqueuePosition.load(std::memory_order_seq_cst) == _dequeuePosition.load(std::memory_order_acquire);
+		}
+
+		void FunctionWrapper() {
+			std::size_t spins = 0;
+			while (_run.load(std::memory_order_acquire)) {
+				if (!_pause.load(std::memory_order_acquire) && TryDequeue([this](args_type& args) { std::apply(_functor, std::move(args)); })) {
+					_pending.fetch_sub(1, std::memory_order_acq_rel);
+					spins = 0;
+					continue;
+				}
+				if (++spins < SpinCount) {
+					std::this_thread::yield();
+					continue;
+				}
+				// Producers read _sleepingThreads after publishing, so either they see this increment or the recheck sees their work
+				lock_type lock(_sleepMutex);
+				_sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+				_conditionVariable.wait(lock, [this]() { return !_run.load(std::memory_order_acquire) || !Idle(); });
+				_sleepingThreads.fetch_sub(1, std::memory_order_relaxed);
+				spins = 0;
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#include <process.h>
+#else
+#include <climits>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace Threading {
+	// Joinable thread with a chosen stack size, std::thread always reserves the platform default (8 MiB on most Linux systems)
+	// Stack size zero keeps the default, other sizes are rounded up to the page size and the platform minimum
+	class WorkerThread {
+	public:
+		using function_type = std::function<void()>;
+	protected:
+#if defined(_WIN32)
+		HANDLE _handle;
+#else
+		pthread_t _handle;
+		bool _joinable;
+#endif
+	public:
+#if defined(_WIN32)
+		WorkerThread() noexcept : _handle(nullptr) {
+#else
+		WorkerThread() noexcept : _handle(), _joinable(false) {
+#endif
+
+		}
+
+		template <class _FuncTy, class..._ArgsTy>
+		WorkerThread(std::size_t stackSize, _FuncTy functor, _ArgsTy...args) : WorkerThread() {
+			Start(stackSize, std::bind(functor, args...));
+		}
+
+		WorkerThread(WorkerThread&& other) noexcept : WorkerThread() {
+			Swap(other);
+		}
+
+		WorkerThread& operator=(WorkerThread&& other) noexcept {
+			if (this != &other) {
+				if (joinable()) {
+					std::terminate();
+				}
+				Swap(other);
+			}
+			return *this;
+		}
+
+		WorkerThread(const WorkerThread&) = delete;
+		WorkerThread& operator=(const WorkerThread&) = delete;
+
+		// Like std::thread, destroying a thread that was never joined terminates the process
+		~WorkerThread() {
+			if (joinable()) {
+				std::terminate();
+			}
+		}
+
+		bool joinable() const noexcept {
+#if defined(_WIN32)
+			return _handle != nullptr;
+#else
+			return _joinable;
+#endif
+		}
+
+		void join() {
+#if defined(_WIN32)
+			WaitForSingleObject(_handle, INFINITE);
+			CloseHandle(_handle);
+			_handle = nullptr;
+#else
+			pthread_join(_handle, nullptr);
+			_joinable = false;
+#endif
+		}
+
+		// Restricts the thread to one logical processor, false when that failed or the platform has no thread affinity
+		bool SetAffinity(int cpu) {
+			if (!joinable() || cpu < 0) {
+				return false;
+			}
+#if defined(_WIN32)
+			return cpu < 64 && SetThreadAffinityMask(_handle, (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+			if (cpu >= CPU_SETSIZE) {
+				return false;
+			}
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu, &set);
+			return pthread_setaffinity_np(_handle, sizeof(set), &set) == 0;
+#else
+			return false;
+#endif
+		}
+
+		// Stack reserved for a thread created with stackSize, what a worker actually reserves
+		static std::size_t StackSize(std::size_t stackSize) {
+#if defined(_WIN32)
+			// Executables reserve 1 MiB per thread unless linked with a different /STACK
+			return stackSize ? RoundUp(stackSize, 64 << 10) : 1 << 20;
+#else
+			if (stackSize == 0) {
+				pthread_attr_t attributes;
+				pthread_attr_init(&attributes);
+				pthread_attr_getstacksize(&attributes, &stackSize);
+				pthread_attr_destroy(&attributes);
+				return stackSize;
+			}
+			std::size_t minimum = PTHREAD_STACK_MIN;
+			return RoundUp(stackSize < minimum ? minimum : stackSize, (std::size_t)sysconf(_SC_PAGESIZE));
+#endif
+		}
+	private:
+		static std::size_t RoundUp(std::size_t value, std::size_t multiple) {
+			return (value + multiple - 1) / multiple * multiple;
+		}
+
+		void Swap(WorkerThread& other) noexcept {
+			std::swap(_handle, other._handle);
+#if !defined(_WIN32)
+			std::swap(_joinable, other._joinable);
+#endif
+		}
+
+		void Start(std::size_t stackSize, function_type function) {
+			std::unique_ptr<function_type> entry(new function_type(std::move(function)));
+#if defined(_WIN32)
+			// The size is a reservation, committed pages still grow on demand
+			_handle = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, stackSize ? (unsigned)StackSize(stackSize) : 0, &WorkerThread::Entry, entry.get(), stackSize ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0, nullptr));
+			if (_handle == nullptr) {
+				throw std::system_error(errno, std::generic_category(), "WorkerThread");
+			}
+#else
+			pthread_attr_t attributes;
+			pthread_attr_init(&attributes);
+			int result = stackSize ? pthread_attr_setstacksize(&attributes, StackSize(stackSize)) : 0;
+			if (result == 0) {
+				result = pthread_create(&_handle, &attributes, &WorkerThread::Entry, entry.get());
+			}
+			pthread_attr_destroy(&attributes);
+			if (result != 0) {
+				throw std::system_error(result, std::generic_category(), "WorkerThread");
+			}
+			_joinable = true;
+#endif
+			entry.release();
+		}
+
+#if defined(_WIN32)
+		static unsigned __stdcall Entry(void* argument) {
+#else
+		static void* Entry(void* argument) {
+#endif
+			std::unique_ptr<function_type> entry(static_cast<function_type*>(argument));
+			(*entry)();
+#if defined(_WIN32)
+			return 0;
+#else
+			return nullptr;
+#endif
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Minimal benchmark registry, each benchmark prints one line per measured configuration
+namespace Benchmark {
+	using clock_type = std::chrono::steady_clock;
+
+	inline std::vector<std::pair<std::string, std::function<void()>>>& Registry() {
+		static std::vector<std::pair<std::string, std::function<void()>>> registry;
+		return registry;
+	}
+
+	struct Registration {
+		Registration(const char* name, std::function<void()> benchmark) {
+			Registry().emplace_back(name, benchmark);
+		}
+	};
+
+	// Best of repetitions in milliseconds, setup runs untimed before every repetition
+	template <class _SetupTy, class _FuncTy>
+	double Measure(std::size_t repetitions, _SetupTy setup, _FuncTy functor) {
+		double best = 0;
+		for (std::size_t i = 0; i < repetitions; ++i) {
+			setup();
+			clock_type::time_point start = clock_type::now();
+			functor();
+			double elapsed = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+			best = (i == 0 || elapsed < best) ? elapsed : best;
+		}
+		return best;
+	}
+
+	template <class _FuncTy>
+	double Measure(std::size_t repetitions, _FuncTy functor) {
+		return Measure(repetitions, []() {}, functor);
+	}
+
+	// 1, 2, 4, ... up to the hardware thread count (always included)
+	inline std::vector<std::size_t> ThreadCounts() {
+		std::size_t hardware = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		std::vector<std::size_t> counts;
+		for (std::size_t count = 1; count < hardware; count *= 2) {
+			counts.push_back(count);
+		}
+		counts.push_back(hardware);
+		return counts;
+	}
+
+	inline void Report(const char* benchmark, const char* variant, std::size_t threads, std::size_t items, double milliseconds) {
+		double rate = milliseconds > 0 ? items / (milliseconds * 1000.0) : 0;
+		std::printf("%-24s %-34s threads=%-4zu items=%-10zu %10.3f ms %10.2f Mitems/s\n", benchmark, variant, threads, items, milliseconds, rate);
+		std::fflush(stdout);
+	}
+}
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static Benchmark::Registration name##_registration(#name, name); \
+	static void name()
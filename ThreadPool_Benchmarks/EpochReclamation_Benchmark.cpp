@@ -0,0 +1,47 @@
+#include "Benchmark.hpp"
+#include "EpochReclamation.hpp"
+#include <atomic>
+
+namespace {
+	const std::size_t OPERATIONS = 1 << 20;
+	const std::size_t REPETITIONS = 3;
+
+	struct Node {
+		long long value;
+		char payload[56];
+	};
+}
+
+// Constant churn, every thread swaps a shared node and retires the old one, items are retirements
+BENCHMARK(EpochReclamation) {
+	for (std::size_t collectThreshold : { (std::size_t)16, Threading::EpochDomain::DefaultCollectThreshold, (std::size_t)1024 }) {
+		for (std::size_t threads : Benchmark::ThreadCounts()) {
+			std::size_t perThread = OPERATIONS / threads;
+			Threading::EpochMetrics metrics{};
+			double elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+				Threading::EpochDomain domain;
+				std::atomic<Node*> shared(new Node());
+				std::vector<std::thread> workers;
+				for (std::size_t t = 0; t < threads; ++t) {
+					workers.emplace_back([&]() {
+						Threading::EpochDomain::Participant participant(domain, collectThreshold);
+						for (std::size_t i = 0; i < perThread; ++i) {
+							Threading::EpochDomain::Guard guard(participant);
+							Node* old = shared.exchange(new Node(), std::memory_order_acq_rel);
+							participant.Retire(old);
+						}
+					});
+				}
+				for (std::thread& worker : workers) {
+					worker.join();
+				}
+				metrics = domain.GetMetrics();
+				delete shared.load();
+			});
+			char variant[64];
+			std::snprintf(variant, sizeof(variant), "collect threshold %zu", collectThreshold);
+			Benchmark::Report("EpochReclamation", variant, threads, perThread * threads, elapsed);
+			std::printf("%-24s %-34s peak unreclaimed %llu nodes (%llu KiB)\n", "", "", (unsigned long long)metrics.peakUnreclaimed, (unsigned long long)(metrics.peakUnreclaimed * sizeof(Node) / 1024));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "Benchmark.hpp"
+#include "ForkJoin.hpp"
+
+namespace {
+	const long FIBONACCI = 30;
+	const long CUTOFF = 2;
+	const std::size_t REPETITIONS = 3;
+
+	long SerialFibonacci(long n) {
+		return n < 2 ? n : SerialFibonacci(n - 1) + SerialFibonacci(n - 2);
+	}
+
+	long ForkJoinFibonacci(long n) {
+		if (n < CUTOFF) {
+			return SerialFibonacci(n);
+		}
+		long left = 0;
+		long right = 0;
+		Threading::ForkJoin::Invoke([&left, n]() { left = ForkJoinFibonacci(n - 1); }, [&right, n]() { right = ForkJoinFibonacci(n - 2); });
+		return left + right;
+	}
+
+	std::size_t Spawns(long n) {
+		return n < CUTOFF ? 0 : 1 + Spawns(n - 1) + Spawns(n - 2);
+	}
+}
+
+// Fine-grained recursion, items are spawned children so the rate is spawns per second
+BENCHMARK(ForkJoin) {
+	std::size_t spawns = Spawns(FIBONACCI);
+	volatile long sink = 0;
+	double baseline = Benchmark::Measure(REPETITIONS, [&]() { sink = SerialFibonacci(FIBONACCI); });
+	Benchmark::Report("ForkJoin", "serial", 1, spawns, baseline);
+
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		Threading::ForkJoinPool pool(threads);
+		double elapsed = Benchmark::Measure(REPETITIONS, [&]() { pool.Run([&]() { sink = ForkJoinFibonacci(FIBONACCI); }); });
+		Benchmark::Report("ForkJoin", "ForkJoin::Spawn", threads, spawns, elapsed);
+	}
+}
\ No newline at end of file
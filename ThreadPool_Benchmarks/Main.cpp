@@ -0,0 +1,13 @@
+#include "Benchmark.hpp"
+
+// Usage: ThreadPool_Benchmarks [filter], runs every benchmark whose name contains filter
+int main(int argc, char** argv) {
+	std::string filter = argc > 1 ? argv[1] : "";
+	for (auto& benchmark : Benchmark::Registry()) {
+		if (benchmark.first.find(filter) != std::string::npos) {
+			std::printf("== %s\n", benchmark.first.c_str());
+			benchmark.second();
+		}
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "Benchmark.hpp"
+#include "ThreadPoolCPP.hpp"
+#include "ParallelAlgorithms.hpp"
+#include <numeric>
+#include <random>
+
+namespace {
+	const std::size_t ELEMENTS = 1 << 24;
+	const std::size_t REPETITIONS = 5;
+
+	std::vector<long long> RandomValues(std::size_t size) {
+		std::vector<long long> values(size);
+		std::mt19937_64 randomEngine(42);
+		for (long long& value : values) {
+			value = (long long)(randomEngine() >> 16);
+		}
+		return values;
+	}
+}
+
+BENCHMARK(ParallelSort) {
+	const std::vector<long long> input = RandomValues(ELEMENTS);
+	std::vector<long long> values;
+
+	double baseline = Benchmark::Measure(REPETITIONS, [&]() { values = input; }, [&]() { std::sort(values.begin(), values.end()); });
+	Benchmark::Report("ParallelSort", "std::sort", 1, ELEMENTS, baseline);
+
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		Threading::ThreadPoolCPP threadpool(threads);
+		double elapsed = Benchmark::Measure(REPETITIONS, [&]() { values = input; }, [&]() { Threading::ParallelSort(threadpool, values.begin(), values.end()); });
+		Benchmark::Report("ParallelSort", "Threading::ParallelSort", threads, ELEMENTS, elapsed);
+	}
+}
+
+BENCHMARK(ParallelInclusiveScan) {
+	const std::vector<long long> input = RandomValues(ELEMENTS);
+	std::vector<long long> output(ELEMENTS);
+
+	double baseline = Benchmark::Measure(REPETITIONS, [&]() { std::inclusive_scan(input.begin(), input.end(), output.begin()); });
+	Benchmark::Report("ParallelInclusiveScan", "std::inclusive_scan", 1, ELEMENTS, baseline);
+
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		Threading::ThreadPoolCPP threadpool(threads);
+		double elapsed = Benchmark::Measure(REPETITIONS, [&]() { Threading::ParallelInclusiveScan(threadpool, input.begin(), input.end(), output.begin()); });
+		Benchmark::Report("ParallelInclusiveScan", "Threading::ParallelInclusiveScan", threads, ELEMENTS, elapsed);
+	}
+}
+
+BENCHMARK(ParallelExclusiveScan) {
+	const std::vector<long long> input = RandomValues(ELEMENTS);
+	std::vector<long long> output(ELEMENTS);
+
+	double baseline = Benchmark::Measure(REPETITIONS, [&]() { std::exclusive_scan(input.begin(), input.end(), output.begin(), 0LL); });
+	Benchmark::Report("ParallelExclusiveScan", "std::exclusive_scan", 1, ELEMENTS, baseline);
+
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		Threading::ThreadPoolCPP threadpool(threads);
+		double elapsed = Benchmark::Measure(REPETITIONS, [&]() { Threading::ParallelExclusiveScan(threadpool, input.begin(), input.end(), output.begin(), 0LL); });
+		Benchmark::Report("ParallelExclusiveScan", "Threading::ParallelExclusiveScan", threads, ELEMENTS, elapsed);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "Benchmark.hpp"
+#include "TaskGraph.hpp"
+#include "ThreadPoolCPP.hpp"
+#include <atomic>
+
+namespace {
+	// 200 nodes in layers, each node after two of the layer before, like a simulation frame
+	const std::size_t LAYERS = 20;
+	const std::size_t WIDTH = 10;
+	const std::size_t FRAMES = 2000;
+	const std::size_t REPETITIONS = 3;
+	const long WORK = 200;
+
+	void Work(std::atomic<long>* total) {
+		long sum = 0;
+		for (long i = 0; i < WORK; ++i) {
+			sum += i ^ (sum >> 3);
+		}
+		total->fetch_add(sum & 1, std::memory_order_relaxed);
+	}
+
+	void Build(Threading::TaskGraph& graph, std::atomic<long>* total) {
+		for (std::size_t layer = 0; layer < LAYERS; ++layer) {
+			for (std::size_t i = 0; i < WIDTH; ++i) {
+				std::size_t node = graph.AddNode([total]() { Work(total); });
+				if (layer != 0) {
+					graph.AddEdge(node - WIDTH, node);
+					graph.AddEdge(node - WIDTH - i + (i + 1) % WIDTH, node);
+				}
+			}
+		}
+	}
+}
+
+// Per-frame overhead of a fixed dependency graph, items are nodes so the rate is nodes per second
+BENCHMARK(TaskGraph) {
+	std::size_t nodes = LAYERS * WIDTH * FRAMES;
+	std::atomic<long> total(0);
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		Threading::ThreadPoolCPP threadpool(threads);
+		// Ad-hoc, every layer is pushed and waited for, a barrier stands in for the edges
+		double elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+			for (std::size_t frame = 0; frame < FRAMES; ++frame) {
+				for (std::size_t layer = 0; layer < LAYERS; ++layer) {
+					for (std::size_t i = 0; i < WIDTH; ++i) {
+						threadpool.Push(Work, &total);
+					}
+					threadpool.Wait();
+				}
+			}
+		});
+		Benchmark::Report("TaskGraph", "Push+Wait per layer", threads, nodes, elapsed);
+
+		elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+			for (std::size_t frame = 0; frame < FRAMES; ++frame) {
+				Threading::TaskGraph graph;
+				Build(graph, &total);
+				graph.Run(threadpool);
+			}
+		});
+		Benchmark::Report("TaskGraph", "TaskGraph rebuilt per frame", threads, nodes, elapsed);
+
+		Threading::TaskGraph graph;
+		Build(graph, &total);
+		graph.Compile();
+		elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+			for (std::size_t frame = 0; frame < FRAMES; ++frame) {
+				graph.Run(threadpool);
+			}
+		});
+		Benchmark::Report("TaskGraph", "TaskGraph reused", threads, nodes, elapsed);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "Benchmark.hpp"
+#include "ThreadPoolCPP.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <Psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace {
+	const std::size_t TASKS = 1 << 20;
+	const std::size_t REPETITIONS = 3;
+	const std::size_t STARTUP_THREADS = 64;
+	const std::size_t MEMORY_POOLS = 16;
+	const std::size_t MEMORY_THREADS = 8;
+	const std::size_t SCRATCH_BYTES = 256 << 10;
+	const std::size_t STACK_BYTES = 32 << 10;
+
+	void Increment(std::atomic<long long>* total) {
+		total->fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Every 64th task is long, to see whether batches hold short tasks back behind it
+	void Uneven(std::atomic<long long>* total, std::size_t i) {
+		if (i % 64 == 0) {
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::microseconds(50);
+			while (std::chrono::steady_clock::now() < end) {
+
+			}
+		}
+		total->fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Scratch from the worker arena and a deep stack frame, what a heavier task leaves behind in a worker
+	void Touch(std::atomic<long long>* total) {
+		std::vector<unsigned char, Threading::ArenaAllocator<unsigned char>> scratch(SCRATCH_BYTES, 1, Threading::ThreadPoolCPP::ScratchAllocator<unsigned char>());
+		volatile unsigned char frame[STACK_BYTES];
+		for (std::size_t i = 0; i < STACK_BYTES; i += 1024) {
+			frame[i] = scratch[i];
+		}
+		total->fetch_add(frame[0], std::memory_order_relaxed);
+	}
+
+	struct ProcessMemory {
+		double residentMiB;
+		double virtualMiB;
+	};
+
+	// Resident set and address space of the process, Windows reports commit instead of address space
+	ProcessMemory SampleProcessMemory() {
+		const double MiB = 1 << 20;
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters{};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return ProcessMemory{ counters.WorkingSetSize / MiB, counters.PagefileUsage / MiB };
+#elif defined(__linux__)
+		unsigned long long size = 0, resident = 0;
+		if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+			if (std::fscanf(statm, "%llu %llu", &size, &resident) != 2) {
+				size = resident = 0;
+			}
+			std::fclose(statm);
+		}
+		double page = (double)sysconf(_SC_PAGESIZE);
+		return ProcessMemory{ resident * page / MiB, size * page / MiB };
+#else
+		return ProcessMemory{ 0, 0 };
+#endif
+	}
+
+	void ReportMemory(const char* variant, const char* phase, const ProcessMemory& memory, const Threading::MemoryStats& stats) {
+		std::printf("%-24s %-34s pools=%-3zu threads=%-4zu %-8s rss %8.1f MiB vm %8.1f MiB stacks %8.1f MiB arenas %8.1f MiB\n", "Memory", variant, MEMORY_POOLS, stats.threads, phase, memory.residentMiB, memory.virtualMiB, stats.stackBytes / double(1 << 20), stats.arenaMappedBytes / double(1 << 20));
+		std::fflush(stdout);
+	}
+
+	// Construction, one task round trip and destruction
+	double MeasureStartup(Threading::ThreadPoolCPPSettings settings) {
+		std::atomic<long long> total(0);
+		return Benchmark::Measure(REPETITIONS, [&]() {
+			Threading::ThreadPoolCPP threadpool(STARTUP_THREADS, settings);
+			threadpool.Push(Increment, &total);
+			threadpool.Wait();
+		});
+	}
+}
+
+// Micro-tasks through the queue against PushTrivial, a direct call is the floor
+BENCHMARK(TrivialTasks) {
+	std::atomic<long long> total(0);
+	double baseline = Benchmark::Measure(REPETITIONS, [&]() {
+		for (std::size_t i = 0; i < TASKS; ++i) {
+			Increment(&total);
+		}
+	});
+	Benchmark::Report("TrivialTasks", "direct call", 1, TASKS, baseline);
+
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		Threading::ThreadPoolCPP threadpool(threads);
+		double elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+			for (std::size_t i = 0; i < TASKS; ++i) {
+				threadpool.Push(Increment, &total);
+			}
+			threadpool.Wait();
+		});
+		Benchmark::Report("TrivialTasks", "ThreadPoolCPP::Push", threads, TASKS, elapsed);
+		elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+			for (std::size_t i = 0; i < TASKS; ++i) {
+				threadpool.PushTrivial(Increment, &total);
+			}
+			threadpool.Wait();
+		});
+		Benchmark::Report("TrivialTasks", "ThreadPoolCPP::PushTrivial", threads, TASKS, elapsed);
+	}
+}
+
+// Short-lived pools, items is the single task each pool runs
+BENCHMARK(Startup) {
+	Threading::ThreadPoolCPPSettings settings;
+	Benchmark::Report("Startup", "eager", STARTUP_THREADS, 1, MeasureStartup(settings));
+	settings.waitForWorkers = false;
+	Benchmark::Report("Startup", "eager, waitForWorkers = false", STARTUP_THREADS, 1, MeasureStartup(settings));
+	settings.lazyStart = true;
+	Benchmark::Report("Startup", "lazyStart", STARTUP_THREADS, 1, MeasureStartup(settings));
+}
+
+// Small tasks with and without dequeue batches, the variant shows tasks per queue lock
+BENCHMARK(DequeueBatch) {
+	std::atomic<long long> total(0);
+	const std::size_t UNEVEN_TASKS = TASKS / 16;
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		for (std::size_t maxBatch : { (std::size_t)1, (std::size_t)16 }) {
+			Threading::ThreadPoolCPPSettings settings;
+			settings.maxDequeueBatch = maxBatch;
+			Threading::ThreadPoolCPP threadpool(threads, settings);
+			double elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+				for (std::size_t i = 0; i < TASKS; ++i) {
+					threadpool.Push(Increment, &total);
+				}
+				threadpool.Wait();
+			});
+			char variant[64];
+			std::snprintf(variant, sizeof(variant), "batch %zu, %.1f tasks/lock", maxBatch, (double)threadpool.CompletedTasks() / threadpool.DequeueLocks());
+			Benchmark::Report("DequeueBatch", variant, threads, TASKS, elapsed);
+			elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+				for (std::size_t i = 0; i < UNEVEN_TASKS; ++i) {
+					threadpool.Push(Uneven, &total, i);
+				}
+				threadpool.Wait();
+			});
+			std::snprintf(variant, sizeof(variant), "batch %zu, uneven", maxBatch);
+			Benchmark::Report("DequeueBatch", variant, threads, UNEVEN_TASKS, elapsed);
+		}
+	}
+}
+
+// Many pools in one process, RSS and address space when idle, at peak and after idle workers trimmed their arenas
+BENCHMARK(Memory) {
+	for (std::size_t stackSize : { (std::size_t)0, (std::size_t)(64 << 10) }) {
+		Threading::ThreadPoolCPPSettings settings;
+		settings.hugePageArena = true;
+		settings.stackSize = stackSize;
+		settings.idleTrim = std::chrono::milliseconds(100);
+		char variant[64];
+		std::snprintf(variant, sizeof(variant), stackSize ? "stackSize %zu KiB" : "default stack", stackSize >> 10);
+		std::atomic<long long> total(0);
+		std::vector<std::unique_ptr<Threading::ThreadPoolCPP>> threadpools;
+		for (std::size_t i = 0; i < MEMORY_POOLS; ++i) {
+			threadpools.emplace_back(new Threading::ThreadPoolCPP(MEMORY_THREADS, settings));
+		}
+		auto usage = [&]() {
+			Threading::MemoryStats sum{ 0, 0, 0, 0, 0, 0 };
+			for (auto& threadpool : threadpools) {
+				Threading::MemoryStats stats = threadpool->MemoryUsage();
+				sum.threads += stats.threads;
+				sum.stackBytes += stats.stackBytes;
+				sum.arenaMappedBytes += stats.arenaMappedBytes;
+			}
+			return sum;
+		};
+		ReportMemory(variant, "idle", SampleProcessMemory(), usage());
+		for (auto& threadpool : threadpools) {
+			for (std::size_t i = 0; i < 16 * MEMORY_THREADS; ++i) {
+				threadpool->Push(Touch, &total);
+			}
+		}
+		for (auto& threadpool : threadpools) {
+			threadpool->Wait();
+		}
+		ReportMemory(variant, "peak", SampleProcessMemory(), usage());
+		std::this_thread::sleep_for(settings.idleTrim * 3);
+		ReportMemory(variant, "trimmed", SampleProcessMemory(), usage());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "Benchmark.hpp"
+#include "ThreadPoolCPP.hpp"
+#include "TypedThreadPool.hpp"
+#include <atomic>
+
+namespace {
+	const std::size_t TASKS = 1 << 20;
+	const std::size_t REPETITIONS = 3;
+
+	struct Packet {
+		std::atomic<long long>* total;
+		long long value;
+	};
+
+	void ProcessPacket(Packet packet) {
+		packet.total->fetch_add(packet.value, std::memory_order_relaxed);
+	}
+
+	struct ProcessPacketFunctor {
+		void operator()(Packet packet) const {
+			ProcessPacket(packet);
+		}
+	};
+}
+
+// Homogeneous small tasks, type-erased Push against the typed ring
+BENCHMARK(TypedThreadPool) {
+	std::atomic<long long> total(0);
+	for (std::size_t threads : Benchmark::ThreadCounts()) {
+		{
+			Threading::ThreadPoolCPP threadpool(threads);
+			double elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+				for (std::size_t i = 0; i < TASKS; ++i) {
+					threadpool.Push(ProcessPacket, Packet{ &total, (long long)i });
+				}
+				threadpool.Wait();
+			});
+			Benchmark::Report("TypedThreadPool", "ThreadPoolCPP::Push", threads, TASKS, elapsed);
+		}
+		{
+			Threading::TypedThreadPool<ProcessPacketFunctor, Packet> threadpool(threads);
+			double elapsed = Benchmark::Measure(REPETITIONS, [&]() {
+				for (std::size_t i = 0; i < TASKS; ++i) {
+					threadpool.Push(Packet{ &total, (long long)i });
+				}
+				threadpool.Wait();
+			});
+			Benchmark::Report("TypedThreadPool", "TypedThreadPool::Push", threads, TASKS, elapsed);
+		}
+	}
+}
\ No newline at end of file
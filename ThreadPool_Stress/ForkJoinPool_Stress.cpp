@@ -0,0 +1,69 @@
+#include "Stress.hpp"
+#include "ForkJoin.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Threading::ForkJoin;
+	using Threading::ForkJoinPool;
+	using Threading::ForkJoinTask;
+
+	const std::size_t LEAVES = 1 << 21;
+	const std::size_t RUNS = 256;
+
+	// Splits [begin, end) in halves down to single elements, every leaf counts once
+	long long Count(std::size_t begin, std::size_t end) {
+		if (end - begin == 1) {
+			return 1;
+		}
+		std::size_t middle = begin + (end - begin) / 2;
+		long long left = 0;
+		auto body = [&left, begin, middle]() { left = Count(begin, middle); };
+		ForkJoinTask<decltype(body)> child(body);
+		ForkJoin scope;
+		scope.Spawn(child);
+		long long right = Count(middle, end);
+		scope.Sync();
+		return left + right;
+	}
+}
+
+// One deep spawn tree, small deques grow while thieves read them
+STRESS(ForkJoinRecursion) {
+	std::size_t leaves = Stress::Scaled(LEAVES);
+	for (std::size_t capacity : { ForkJoinPool::DefaultDequeCapacity, (std::size_t)2 }) {
+		ForkJoinPool pool(Stress::Threads(), capacity);
+		long long total = 0;
+		double elapsed = Stress::Time([&]() {
+			pool.Run([&total, leaves]() { total = Count(0, leaves); });
+		});
+		Stress::Check(total == (long long)leaves, "ForkJoinRecursion", "every leaf counted once");
+		Stress::Report("ForkJoinRecursion", capacity == 2 ? "dequeCapacity=2" : "default", Stress::Threads(), leaves, elapsed);
+	}
+}
+
+// Several external threads inject roots at once, workers wake, steal and sleep between them
+STRESS(ForkJoinConcurrentRuns) {
+	std::size_t callers = Stress::Threads();
+	std::size_t runs = Stress::Scaled(RUNS);
+	std::size_t leaves = 1 << 10;
+	std::atomic<long long> total(0);
+	ForkJoinPool pool(Stress::Threads());
+	double elapsed = Stress::Time([&]() {
+		std::vector<std::thread> threads;
+		for (std::size_t c = 0; c < callers; ++c) {
+			threads.emplace_back([&]() {
+				for (std::size_t i = 0; i < runs / callers + 1; ++i) {
+					pool.Run([&total, leaves]() { total.fetch_add(Count(0, leaves), std::memory_order_relaxed); });
+				}
+			});
+		}
+		for (std::thread& t : threads) {
+			t.join();
+		}
+	});
+	std::size_t expected = callers * (runs / callers + 1) * leaves;
+	Stress::Check(total.load() == (long long)expected, "ForkJoinConcurrentRuns", "every run counted all its leaves");
+	Stress::Report("ForkJoinConcurrentRuns", "Run from every caller", Stress::Threads(), expected, elapsed);
+}
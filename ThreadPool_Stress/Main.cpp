@@ -0,0 +1,18 @@
+#include "Stress.hpp"
+#include <cstdlib>
+
+// Usage: ThreadPool_Stress [filter] [percent], runs every scenario whose name contains filter with task counts scaled by percent
+// Returns non-zero when an invariant failed, sanitizers report races and leaks on their own
+int main(int argc, char** argv) {
+	std::string filter = argc > 1 ? argv[1] : "";
+	if (argc > 2) {
+		Stress::Percent() = std::max(1, std::atoi(argv[2]));
+	}
+	for (auto& scenario : Stress::Registry()) {
+		if (scenario.first.find(filter) != std::string::npos) {
+			std::printf("== %s\n", scenario.first.c_str());
+			scenario.second();
+		}
+	}
+	return Stress::Failures() == 0 ? 0 : 1;
+}
\ No newline at end of file
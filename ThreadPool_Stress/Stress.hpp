@@ -0,0 +1,73 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Minimal stress registry, a scenario checks its invariants and prints one throughput line per variant
+namespace Stress {
+	using clock_type = std::chrono::steady_clock;
+
+	inline std::vector<std::pair<std::string, std::function<void()>>>& Registry() {
+		static std::vector<std::pair<std::string, std::function<void()>>> registry;
+		return registry;
+	}
+
+	struct Registration {
+		Registration(const char* name, std::function<void()> scenario) {
+			Registry().emplace_back(name, scenario);
+		}
+	};
+
+	// Percentage applied to every task count, lowered for sanitizer builds that run several times slower
+	inline std::size_t& Percent() {
+		static std::size_t percent = 100;
+		return percent;
+	}
+
+	inline std::atomic<std::size_t>& Failures() {
+		static std::atomic<std::size_t> failures(0);
+		return failures;
+	}
+
+	inline std::size_t Scaled(std::size_t count) {
+		return std::max<std::size_t>(1, count * Percent() / 100);
+	}
+
+	// At least four workers so that a small machine still runs them contended
+	inline std::size_t Threads() {
+		return std::max<std::size_t>(4, std::thread::hardware_concurrency());
+	}
+
+	inline void Check(bool condition, const char* scenario, const char* description) {
+		if (!condition) {
+			++Failures();
+			std::printf("FAILED %s: %s\n", scenario, description);
+			std::fflush(stdout);
+		}
+	}
+
+	template <class _FuncTy>
+	double Time(_FuncTy functor) {
+		clock_type::time_point start = clock_type::now();
+		functor();
+		return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+	}
+
+	inline void Report(const char* scenario, const char* variant, std::size_t threads, std::size_t tasks, double milliseconds) {
+		double rate = milliseconds > 0 ? tasks / (milliseconds * 1000.0) : 0;
+		std::printf("%-24s %-30s threads=%-4zu tasks=%-10zu %10.3f ms %10.2f Mtasks/s\n", scenario, variant, threads, tasks, milliseconds, rate);
+		std::fflush(stdout);
+	}
+}
+
+#define STRESS(name) \
+	static void name(); \
+	static Stress::Registration name##_registration(#name, name); \
+	static void name()
@@ -0,0 +1,266 @@
+#include "Stress.hpp"
+#include "ThreadPoolCPP.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Threading::ThreadPoolCPP;
+	using Threading::ThreadPoolCPPSettings;
+
+	const std::size_t MILLIONS = 1 << 22;
+	const std::size_t PRODUCED = 1 << 21;
+	const std::size_t TREE = 1 << 21;
+	const std::size_t BATCH = 16;
+
+	void Increment(std::atomic<long long>* total) {
+		total->fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Every node pushes two children until depth runs out, 2^(depth + 1) - 1 nodes in total
+	void Tree(ThreadPoolCPP* threadpool, std::atomic<long long>* total, std::size_t depth, bool trivial) {
+		total->fetch_add(1, std::memory_order_relaxed);
+		if (depth == 0) {
+			return;
+		}
+		if (trivial) {
+			threadpool->PushTrivial(Tree, threadpool, total, depth - 1, trivial);
+			threadpool->PushTrivial(Tree, threadpool, total, depth - 1, trivial);
+		} else {
+			threadpool->Push(Tree, threadpool, total, depth - 1, trivial);
+			threadpool->Push(Tree, threadpool, total, depth - 1, trivial);
+		}
+	}
+
+	std::size_t TreeDepth(std::size_t nodes) {
+		std::size_t depth = 0;
+		while ((std::size_t(2) << (depth + 1)) - 1 <= nodes) {
+			++depth;
+		}
+		return depth;
+	}
+
+	void Millions(const char* variant, ThreadPoolCPPSettings settings) {
+		std::size_t tasks = Stress::Scaled(MILLIONS);
+		std::atomic<long long> total(0);
+		ThreadPoolCPP threadpool(Stress::Threads(), settings);
+		double elapsed = Stress::Time([&]() {
+			for (std::size_t i = 0; i < tasks; ++i) {
+				threadpool.Push(Increment, &total);
+			}
+			threadpool.Wait();
+		});
+		Stress::Check(total.load() == (long long)tasks, "MillionsOfTasks", variant);
+		Stress::Check(threadpool.CompletedTasks() == tasks, "MillionsOfTasks", "CompletedTasks matches the pushed tasks");
+		Stress::Report("MillionsOfTasks", variant, Stress::Threads(), tasks, elapsed);
+	}
+
+	// Producers push until they reach their share or are told to stop, pushed counts every task handed to the threadpool
+	void Produce(ThreadPoolCPP* threadpool, std::atomic<long long>* executed, std::atomic<long long>* pushed, std::atomic<bool>* stop, std::size_t tasks) {
+		for (std::size_t i = 0; i < tasks && !stop->load(std::memory_order_relaxed); ++i) {
+			threadpool->Push(Increment, executed);
+			pushed->fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Waits inside a BlockingScope until release is set, the release task can only run on a spare worker
+	void Block(std::atomic<bool>* release, std::atomic<long long>* released) {
+		Threading::BlockingScope scope;
+		while (!release->load()) {
+			std::this_thread::yield();
+		}
+		released->fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Release(std::atomic<bool>* release) {
+		release->store(true);
+	}
+
+	void ShutdownWhileProducing(const char* variant, Threading::ShutdownMode mode, std::chrono::milliseconds timeout) {
+		std::size_t producers = Stress::Threads();
+		std::atomic<long long> executed(0);
+		std::atomic<long long> pushed(0);
+		std::atomic<bool> stop(false);
+		ThreadPoolCPP threadpool(Stress::Threads());
+		std::vector<std::thread> threads;
+		for (std::size_t i = 0; i < producers; ++i) {
+			threads.emplace_back(Produce, &threadpool, &executed, &pushed, &stop, Stress::Scaled(PRODUCED) / producers);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		Threading::ShutdownReport report;
+		long long afterShutdown = 0;
+		double elapsed = Stress::Time([&]() {
+			report = threadpool.Shutdown(mode, timeout);
+			afterShutdown = executed.load();
+		});
+		stop.store(true);
+		for (std::thread& t : threads) {
+			t.join();
+		}
+		// Tasks pushed after the shutdown stay queued, a second shutdown drops them
+		Threading::ShutdownReport late = threadpool.Shutdown(Threading::ShutdownMode::DropQueued);
+		if (report.abandoned == 0) {
+			Stress::Check(executed.load() == afterShutdown, "ShutdownUnderLoad", "no task runs after Shutdown returns");
+			Stress::Check(executed.load() + (long long)(report.dropped + late.dropped) == pushed.load(), "ShutdownUnderLoad", "every pushed task either ran or was dropped");
+		}
+		Stress::Check(executed.load() + (long long)(report.dropped + late.dropped) <= pushed.load(), "ShutdownUnderLoad", "no task runs twice");
+		if (mode == Threading::ShutdownMode::Drain) {
+			Stress::Check(!report.timedOut, "ShutdownUnderLoad", "Drain without a timeout never times out");
+		}
+		Stress::Report("ShutdownUnderLoad", variant, Stress::Threads(), (std::size_t)pushed.load(), elapsed);
+	}
+}
+
+// One producer, the workers contend on the queue with each other
+STRESS(MillionsOfTasks) {
+	Millions("default", ThreadPoolCPPSettings());
+	ThreadPoolCPPSettings settings;
+	settings.maxDequeueBatch = 1;
+	Millions("maxDequeueBatch=1", settings);
+	settings = ThreadPoolCPPSettings();
+	settings.lazyStart = true;
+	Millions("lazyStart", settings);
+	settings = ThreadPoolCPPSettings();
+	settings.hugePageArena = true;
+	Millions("hugePageArena", settings);
+}
+
+// Twice as many producers as workers, spread over tenants and every push flavour
+STRESS(ConcurrentProducers) {
+	std::size_t producers = Stress::Threads() * 2;
+	std::size_t tasks = Stress::Scaled(PRODUCED) / producers / BATCH * BATCH * producers;
+	std::atomic<long long> total(0);
+	ThreadPoolCPP threadpool(Stress::Threads());
+	Threading::TenantSettings weighted;
+	weighted.weight = 4;
+	Threading::TenantSettings serial;
+	serial.maxConcurrency = 1;
+	Threading::TenantId tenants[] = { Threading::DefaultTenant, threadpool.CreateTenant(weighted), threadpool.CreateTenant(serial) };
+	double elapsed = Stress::Time([&]() {
+		std::vector<std::thread> threads;
+		for (std::size_t p = 0; p < producers; ++p) {
+			threads.emplace_back([&, p]() {
+				Threading::TenantId tenant = tenants[p % 3];
+				std::vector<ThreadPoolCPP::work_type> works;
+				for (std::size_t i = 0; i < tasks / producers; i += BATCH) {
+					switch ((i / BATCH) % 3) {
+					case 0:
+						for (std::size_t j = 0; j < BATCH; ++j) {
+							threadpool.PushTenant(tenant, Increment, &total);
+						}
+						break;
+					case 1:
+						for (std::size_t j = 0; j < BATCH; ++j) {
+							threadpool.PushTrivial(Increment, &total);
+						}
+						break;
+					default:
+						works.assign(BATCH, [&total]() { Increment(&total); });
+						threadpool.PushBatch(works, tenant);
+						break;
+					}
+				}
+			});
+		}
+		for (std::thread& t : threads) {
+			t.join();
+		}
+		threadpool.Wait();
+	});
+	Stress::Check(total.load() == (long long)tasks, "ConcurrentProducers", "every pushed task ran once");
+	Stress::Check(threadpool.QueuedTasks() == 0, "ConcurrentProducers", "queue is empty after Wait");
+	Stress::Report("ConcurrentProducers", "Push/PushTrivial/PushBatch", Stress::Threads(), tasks, elapsed);
+}
+
+// Producers keep pushing while other threads pause, resume and wait on the threadpool at random
+STRESS(PauseResumeWaitStorm) {
+	std::size_t producers = Stress::Threads();
+	std::size_t tasks = Stress::Scaled(PRODUCED) / producers * producers;
+	std::atomic<long long> total(0);
+	std::atomic<long long> pushed(0);
+	std::atomic<bool> stop(false);
+	std::atomic<bool> storming(true);
+	ThreadPoolCPP threadpool(Stress::Threads());
+	double elapsed = Stress::Time([&]() {
+		std::vector<std::thread> storm;
+		for (std::size_t i = 0; i < 2; ++i) {
+			storm.emplace_back([&]() {
+				while (storming.load()) {
+					threadpool.Pause();
+					std::this_thread::yield();
+					threadpool.Resume();
+					std::this_thread::yield();
+				}
+			});
+			storm.emplace_back([&]() {
+				while (storming.load()) {
+					threadpool.Wait();
+				}
+			});
+		}
+		std::vector<std::thread> threads;
+		for (std::size_t i = 0; i < producers; ++i) {
+			threads.emplace_back(Produce, &threadpool, &total, &pushed, &stop, tasks / producers);
+		}
+		for (std::thread& t : threads) {
+			t.join();
+		}
+		storming.store(false);
+		for (std::thread& t : storm) {
+			t.join();
+		}
+		threadpool.Resume();
+		threadpool.Wait();
+	});
+	Stress::Check(pushed.load() == (long long)tasks, "PauseResumeWaitStorm", "producers pushed their share");
+	Stress::Check(total.load() == (long long)tasks, "PauseResumeWaitStorm", "every task ran once after the final Resume");
+	Stress::Report("PauseResumeWaitStorm", "2 pausers, 2 waiters", Stress::Threads(), tasks, elapsed);
+}
+
+// Tasks push their own children, the queue is fed by the workers themselves
+STRESS(RecursivePush) {
+	std::size_t depth = TreeDepth(Stress::Scaled(TREE));
+	long long nodes = ((long long)2 << depth) - 1;
+	for (bool trivial : { false, true }) {
+		std::atomic<long long> total(0);
+		ThreadPoolCPP threadpool(Stress::Threads());
+		double elapsed = Stress::Time([&]() {
+			threadpool.Push(Tree, &threadpool, &total, depth, trivial);
+			threadpool.Wait();
+		});
+		Stress::Check(total.load() == nodes, "RecursivePush", trivial ? "PushTrivial tree" : "Push tree");
+		Stress::Report("RecursivePush", trivial ? "PushTrivial" : "Push", Stress::Threads(), (std::size_t)nodes, elapsed);
+	}
+}
+
+// Wait runs while BlockingScope starts spare workers, it must not return before the blocked tasks finish
+STRESS(BlockingWait) {
+	std::size_t rounds = Stress::Scaled(2000);
+	std::size_t early = 0;
+	ThreadPoolCPPSettings settings;
+	settings.maxSpareThreads = 2;
+	double elapsed = Stress::Time([&]() {
+		for (std::size_t i = 0; i < rounds; ++i) {
+			// A fresh threadpool every round so the spare workers are started, not woken
+			ThreadPoolCPP threadpool(2, settings);
+			std::atomic<bool> release(false);
+			std::atomic<long long> released(0);
+			threadpool.Push(Block, &release, &released);
+			threadpool.Push(Block, &release, &released);
+			threadpool.Push(Release, &release);
+			threadpool.Wait();
+			early += released.load() != 2;
+			release.store(true);
+		}
+	});
+	Stress::Check(early == 0, "BlockingWait", "Wait returns after every blocked task finished");
+	Stress::Report("BlockingWait", "2 workers, 2 spares", 2, rounds * 3, elapsed);
+}
+
+// Producers are still pushing when the threadpool shuts down
+STRESS(ShutdownUnderLoad) {
+	ShutdownWhileProducing("Drain", Threading::ShutdownMode::Drain, std::chrono::milliseconds::max());
+	ShutdownWhileProducing("DropQueued", Threading::ShutdownMode::DropQueued, std::chrono::milliseconds::max());
+	ShutdownWhileProducing("Deadline 5ms", Threading::ShutdownMode::Deadline, std::chrono::milliseconds(5));
+}
\ No newline at end of file
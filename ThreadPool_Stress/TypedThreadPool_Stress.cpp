@@ -0,0 +1,43 @@
+#include "Stress.hpp"
+#include "TypedThreadPool.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Threading::TypedThreadPool;
+
+	const std::size_t PRODUCED = 1 << 21;
+
+	struct Accumulate {
+		void operator()(std::atomic<long long>* total, long long value) const {
+			total->fetch_add(value, std::memory_order_relaxed);
+		}
+	};
+}
+
+// Producers outnumber workers and fill a small ring, both the full-ring and the empty-ring paths are hit
+STRESS(TypedProducers) {
+	std::size_t producers = Stress::Threads() * 2;
+	std::size_t tasks = Stress::Scaled(PRODUCED) / producers * producers;
+	for (std::size_t capacity : { (std::size_t)64, (std::size_t)1 << 16 }) {
+		std::atomic<long long> total(0);
+		TypedThreadPool<Accumulate, std::atomic<long long>*, long long> threadpool(Stress::Threads(), Accumulate(), capacity);
+		double elapsed = Stress::Time([&]() {
+			std::vector<std::thread> threads;
+			for (std::size_t p = 0; p < producers; ++p) {
+				threads.emplace_back([&]() {
+					for (std::size_t i = 0; i < tasks / producers; ++i) {
+						threadpool.Push(&total, 1LL);
+					}
+				});
+			}
+			for (std::thread& t : threads) {
+				t.join();
+			}
+			threadpool.Wait();
+		});
+		Stress::Check(total.load() == (long long)tasks, "TypedProducers", "every pushed task ran once");
+		Stress::Report("TypedProducers", capacity == 64 ? "capacity=64" : "capacity=65536", Stress::Threads(), tasks, elapsed);
+	}
+}
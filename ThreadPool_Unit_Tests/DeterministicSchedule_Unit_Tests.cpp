@@ -0,0 +1,100 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(DeterministicScheduleUnitTests) {
+	public:
+		static Threading::Schedule RecordSeeded(Threading::ThreadPoolCPP& threadpool, std::uint64_t seed, std::vector<long>& order, long repetitions) {
+			threadpool.Wait();
+			// Everything is queued before any worker drains, so the seed alone decides the order
+			threadpool.Pause();
+			threadpool.StartRecording(seed);
+			for (long i = 1; i <= repetitions; ++i) {
+				threadpool.Push(StrandTest::Record, &order, i);
+			}
+			threadpool.Resume();
+			threadpool.Wait();
+			return threadpool.StopDeterministic();
+		}
+
+		TEST_METHOD(DeterministicSchedule_Record) {
+			Logger::WriteMessage("DeterministicSchedule->Record: Start\n");
+			Threading::ThreadPoolCPP threadpool(4);
+			const long REPETITION_NUMBER = 500;
+			std::vector<long> first;
+			std::vector<long> second;
+			Threading::Schedule schedule = RecordSeeded(threadpool, 42, first, REPETITION_NUMBER);
+			Threading::Schedule repeated = RecordSeeded(threadpool, 42, second, REPETITION_NUMBER);
+
+			// One task at a time, so the unsynchronised Record calls above are safe and match the schedule
+			Assert::AreEqual((std::size_t)REPETITION_NUMBER, schedule.entries.size());
+			Assert::IsTrue(first == second);
+			bool shuffled = false;
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				Assert::AreEqual((std::uint64_t)first[i], schedule.entries[i].sequence);
+				shuffled = shuffled || first[i] != i + 1;
+			}
+			Assert::IsTrue(shuffled);
+			Assert::IsFalse(threadpool.Deterministic());
+
+			// Seed zero keeps submission order
+			std::vector<long> ordered;
+			RecordSeeded(threadpool, 0, ordered, REPETITION_NUMBER);
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				Assert::AreEqual(i + 1, ordered[i]);
+			}
+			Logger::WriteMessage("DeterministicSchedule->Record: End\n");
+		}
+
+		TEST_METHOD(DeterministicSchedule_Replay) {
+			Logger::WriteMessage("DeterministicSchedule->Replay: Start\n");
+			Threading::ThreadPoolCPP threadpool(4);
+			const long REPETITION_NUMBER = 500;
+			std::vector<long> recorded;
+			Threading::Schedule schedule = RecordSeeded(threadpool, 7, recorded, REPETITION_NUMBER);
+
+			const char* path = "DeterministicSchedule_Replay.txt";
+			Assert::IsTrue(Threading::SaveSchedule(path, schedule));
+			Threading::Schedule loaded;
+			Assert::IsTrue(Threading::LoadSchedule(path, loaded));
+			std::remove(path);
+			Assert::AreEqual((std::uint64_t)7, loaded.seed);
+			Assert::AreEqual(schedule.entries.size(), loaded.entries.size());
+
+			// Workers start draining while tasks are still being pushed, replay holds them to the recorded order
+			std::vector<long> replayed;
+			threadpool.StartReplay(loaded);
+			for (long i = 1; i <= REPETITION_NUMBER; ++i) {
+				threadpool.Push(StrandTest::Record, &replayed, i);
+			}
+			threadpool.Wait();
+			Threading::Schedule actual = threadpool.StopDeterministic();
+			Assert::IsFalse(actual.diverged);
+			Assert::IsTrue(recorded == replayed);
+			Logger::WriteMessage("DeterministicSchedule->Replay: End\n");
+		}
+
+		TEST_METHOD(DeterministicSchedule_Diverged) {
+			Logger::WriteMessage("DeterministicSchedule->Diverged: Start\n");
+			Threading::ThreadPoolCPP threadpool(2);
+			Threading::Schedule schedule;
+			schedule.entries.push_back(Threading::ScheduleEntry{ 1000, 0 });
+			std::vector<long> order;
+			threadpool.StartReplay(schedule, std::chrono::milliseconds(20));
+			for (long i = 1; i <= 10; ++i) {
+				threadpool.Push(StrandTest::Record, &order, i);
+			}
+			threadpool.Wait();
+			Threading::Schedule actual = threadpool.StopDeterministic();
+			Assert::IsTrue(actual.diverged);
+			Assert::AreEqual((std::size_t)10, order.size());
+			Logger::WriteMessage("DeterministicSchedule->Diverged: End\n");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "EpochReclamation.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(EpochReclamationUnitTests) {
+	public:
+		TEST_METHOD(EpochReclamation_Reclaim) {
+			Logger::WriteMessage("EpochReclamation->Reclaim: Start\n");
+			std::atomic<long> destroyed(0);
+			{
+				Threading::EpochDomain domain;
+				Threading::EpochDomain::Participant writer(domain, 1);
+				for (long i = 0; i < 10; ++i) {
+					writer.Retire(new EpochTest::Node(&destroyed));
+				}
+				// No reader is inside a guard, so a few collects advance the epoch far enough to free everything
+				for (long i = 0; i < 3; ++i) {
+					writer.Collect();
+				}
+				Assert::AreEqual(10L, destroyed.load());
+				Assert::AreEqual((std::size_t)0, writer.Pending());
+				Threading::EpochMetrics metrics = domain.GetMetrics();
+				Assert::AreEqual((std::uint64_t)10, metrics.retired);
+				Assert::AreEqual((std::uint64_t)10, metrics.reclaimed);
+				Assert::AreEqual((std::uint64_t)0, metrics.unreclaimed);
+			}
+			Logger::WriteMessage("EpochReclamation->Reclaim: End\n");
+		}
+
+		TEST_METHOD(EpochReclamation_GuardDefers) {
+			Logger::WriteMessage("EpochReclamation->GuardDefers: Start\n");
+			std::atomic<long> destroyed(0);
+			{
+				Threading::EpochDomain domain;
+				Threading::EpochDomain::Participant writer(domain, 1);
+				Threading::EpochDomain::Participant reader(domain);
+				{
+					Threading::EpochDomain::Guard guard(reader);
+					writer.Retire(new EpochTest::Node(&destroyed));
+					for (long i = 0; i < 10; ++i) {
+						writer.Collect();
+					}
+					// The reader entered before the retire and may still hold the node
+					Assert::AreEqual(0L, destroyed.load());
+				}
+				for (long i = 0; i < 3; ++i) {
+					writer.Collect();
+				}
+				Assert::AreEqual(1L, destroyed.load());
+				Assert::AreEqual((std::size_t)2, domain.GetMetrics().participants);
+			}
+			Logger::WriteMessage("EpochReclamation->GuardDefers: End\n");
+		}
+
+		TEST_METHOD(EpochReclamation_Churn) {
+			Logger::WriteMessage("EpochReclamation->Churn: Start\n");
+			const long NUMBER_THREADS = 4;
+			const long REPETITION_NUMBER = 20000;
+			std::atomic<long> destroyed(0);
+			std::atomic<long> corrupted(0);
+			{
+				Threading::EpochDomain domain;
+				std::atomic<EpochTest::Node*> shared(new EpochTest::Node(&destroyed));
+				std::vector<std::thread> threads;
+				for (long t = 0; t < NUMBER_THREADS; ++t) {
+					threads.emplace_back([&]() {
+						Threading::EpochDomain::Participant participant(domain);
+						for (long i = 0; i < REPETITION_NUMBER; ++i) {
+							Threading::EpochDomain::Guard guard(participant);
+							EpochTest::Node* node = shared.load(std::memory_order_acquire);
+							if (node->magic != EpochTest::Node::Magic) {
+								++corrupted;
+							}
+							// Every other iteration replaces the node, the old one may still be read by others
+							if (i % 2 == 0) {
+								EpochTest::Node* old = shared.exchange(new EpochTest::Node(&destroyed), std::memory_order_acq_rel);
+								participant.Retire(old);
+							}
+						}
+					});
+				}
+				for (std::thread& t : threads) {
+					t.join();
+				}
+				Threading::EpochMetrics metrics = domain.GetMetrics();
+				Assert::AreEqual((std::uint64_t)(NUMBER_THREADS * REPETITION_NUMBER / 2), metrics.retired);
+				Assert::AreEqual((std::size_t)0, metrics.participants);
+				delete shared.load();
+			}
+			Assert::AreEqual(0L, corrupted.load());
+			Assert::AreEqual(NUMBER_THREADS * REPETITION_NUMBER / 2 + 1, destroyed.load());
+			Logger::WriteMessage("EpochReclamation->Churn: End\n");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(FairQueueUnitTests) {
+	public:
+		TEST_METHOD(FairQueue_Weights) {
+			Logger::WriteMessage("FairQueue->Weights: Start\n");
+			Threading::ThreadPoolCPP threadpool(1);
+			const long REPETITION_NUMBER = 300;
+			Threading::TenantSettings light;
+			light.name = "light";
+			Threading::TenantSettings heavy;
+			heavy.name = "heavy";
+			heavy.weight = 2;
+			Threading::TenantId lightTenant = threadpool.CreateTenant(light);
+			Threading::TenantId heavyTenant = threadpool.CreateTenant(heavy);
+			std::vector<long> order;
+			order.reserve(REPETITION_NUMBER * 2);
+
+			// Queue everything first so the single worker sees both tenants backlogged
+			threadpool.Pause();
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.PushTenant(lightTenant, StrandTest::Record, &order, 1L);
+				threadpool.PushTenant(heavyTenant, StrandTest::Record, &order, 2L);
+			}
+			Assert::AreEqual((std::size_t)REPETITION_NUMBER * 2, threadpool.QueuedTasks());
+			threadpool.Resume();
+			threadpool.Wait();
+
+			Assert::AreEqual((std::size_t)REPETITION_NUMBER * 2, order.size());
+			// While both are backlogged heavy runs two tasks for every one of light
+			for (long i = 0; i < REPETITION_NUMBER; i += 3) {
+				Assert::AreEqual(1L, order[i]);
+				Assert::AreEqual(2L, order[i + 1]);
+				Assert::AreEqual(2L, order[i + 2]);
+			}
+
+			Threading::TenantMetrics metrics = threadpool.GetTenantMetrics(heavyTenant);
+			Assert::AreEqual(std::string("heavy"), metrics.name);
+			Assert::AreEqual((std::uint64_t)REPETITION_NUMBER, metrics.submitted);
+			Assert::AreEqual((std::uint64_t)REPETITION_NUMBER, metrics.completed);
+			Assert::AreEqual((std::size_t)0, metrics.queued);
+			Assert::AreEqual((std::size_t)REPETITION_NUMBER, metrics.peakQueued);
+			Assert::AreEqual((std::size_t)0, metrics.running);
+			Assert::AreEqual((std::size_t)3, threadpool.Tenants());
+			Logger::WriteMessage("FairQueue->Weights: End\n");
+		}
+
+		TEST_METHOD(FairQueue_ConcurrencyCap) {
+			Logger::WriteMessage("FairQueue->ConcurrencyCap: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			const long REPETITION_NUMBER = 64;
+			Threading::TenantSettings capped;
+			capped.name = "capped";
+			capped.maxConcurrency = 2;
+			Threading::TenantId cappedTenant = threadpool.CreateTenant(capped);
+			StrandTest::Monitor cappedMonitor;
+			StrandTest::Monitor defaultMonitor;
+
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.PushTenant(cappedTenant, HillClimbingTest::Measure, &cappedMonitor, std::chrono::microseconds(200));
+				threadpool.Push(HillClimbingTest::Measure, &defaultMonitor, std::chrono::microseconds(200));
+			}
+			threadpool.Wait();
+
+			Assert::AreEqual(REPETITION_NUMBER, cappedMonitor.executed.load());
+			Assert::AreEqual(REPETITION_NUMBER, defaultMonitor.executed.load());
+			Assert::IsTrue(cappedMonitor.maxConcurrent.load() <= 2);
+			Threading::TenantMetrics metrics = threadpool.GetTenantMetrics(cappedTenant);
+			Assert::AreEqual((std::uint64_t)REPETITION_NUMBER, metrics.completed);
+			Assert::AreEqual((std::size_t)0, metrics.running);
+			Logger::WriteMessage("FairQueue->ConcurrencyCap: Cap Passed\n");
+
+			// An id CreateTenant did not return is rejected before anything is queued
+			std::atomic<long> executed(0);
+			Threading::TenantId unknown = cappedTenant + 1;
+			std::vector<Threading::ThreadPoolCPP::work_type> works(3, [&executed]() { executed.fetch_add(1); });
+			Assert::ExpectException<std::out_of_range>([&]() { threadpool.PushTenant(unknown, ShutdownTest::Count, &executed); });
+			Assert::ExpectException<std::out_of_range>([&]() { threadpool.PushDeadlineTenant(unknown, std::chrono::steady_clock::now(), nullptr, ShutdownTest::Count, &executed); });
+			Assert::ExpectException<std::out_of_range>([&]() { threadpool.PushBatch(works, unknown); });
+			Assert::ExpectException<std::out_of_range>([&]() { threadpool.GetTenantMetrics(unknown); });
+			threadpool.Wait();
+			Assert::AreEqual((std::size_t)3, works.size());
+			Assert::AreEqual(0L, executed.load());
+			Logger::WriteMessage("FairQueue->ConcurrencyCap: End\n");
+		}
+
+		TEST_METHOD(FairQueue_EarliestDeadlineFirst) {
+			Logger::WriteMessage("FairQueue->EarliestDeadlineFirst: Start\n");
+			Threading::ThreadPoolCPP threadpool(1);
+			const long REPETITION_NUMBER = 100;
+			Threading::TenantSettings settings;
+			settings.name = "rpc";
+			settings.earliestDeadlineFirst = true;
+			Threading::TenantId rpcTenant = threadpool.CreateTenant(settings);
+			std::vector<long> order;
+			std::atomic<long> expired(0);
+			Threading::ThreadPoolCPP::deadline_type now = std::chrono::steady_clock::now();
+
+			threadpool.Pause();
+			// Deadlines in scrambled order, far enough out to still be pending when they run
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				long rank = (i * 37) % REPETITION_NUMBER;
+				threadpool.PushDeadlineTenant(rpcTenant, now + std::chrono::hours(1) + std::chrono::milliseconds(rank), nullptr, StrandTest::Record, &order, rank);
+			}
+			// Already late, dropped with the hook instead of run
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.PushDeadlineTenant(rpcTenant, now - std::chrono::milliseconds(1), [&expired]() { ++expired; }, StrandTest::Record, &order, -1L);
+			}
+			threadpool.PushDeadline(now - std::chrono::milliseconds(1), StrandTest::Record, &order, -1L);
+			threadpool.Resume();
+			threadpool.Wait();
+
+			Assert::AreEqual((std::size_t)REPETITION_NUMBER, order.size());
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				Assert::AreEqual(i, order[i]);
+			}
+			Assert::AreEqual(REPETITION_NUMBER, expired.load());
+			Assert::AreEqual((std::uint64_t)REPETITION_NUMBER + 1, threadpool.ExpiredTasks());
+			Assert::AreEqual((std::uint64_t)REPETITION_NUMBER, threadpool.CompletedTasks());
+			Threading::TenantMetrics metrics = threadpool.GetTenantMetrics(rpcTenant);
+			Assert::AreEqual((std::size_t)0, metrics.running);
+			Assert::AreEqual((std::size_t)0, metrics.queued);
+			Logger::WriteMessage("FairQueue->EarliestDeadlineFirst: End\n");
+		}
+	};
+}
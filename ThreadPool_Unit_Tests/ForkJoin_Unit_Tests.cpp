@@ -0,0 +1,87 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ForkJoin.hpp"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(ForkJoinUnitTests) {
+	public:
+		TEST_METHOD(ForkJoin_Constructor) {
+			Threading::ForkJoinPool pool(8);
+			Assert::AreEqual((std::size_t)8, pool.Size());
+			Logger::WriteMessage("ForkJoin->Constructor Passed.\n");
+		}
+
+		TEST_METHOD(ForkJoin_Fibonacci) {
+			Logger::WriteMessage("ForkJoin->Fibonacci: Start\n");
+			Threading::ForkJoinPool pool(8);
+			for (long n : { 0L, 1L, 11L, 12L, 20L, 25L }) {
+				long result = -1;
+				pool.Run([&result, n]() { result = ForkJoinTest::Fibonacci(n); });
+				long a = 0;
+				long b = 1;
+				for (long i = 0; i < n; ++i) {
+					long next = a + b;
+					a = b;
+					b = next;
+				}
+				Assert::AreEqual(a, result);
+			}
+			Logger::WriteMessage("ForkJoin->Fibonacci: End\n");
+		}
+
+		TEST_METHOD(ForkJoin_QuickSort) {
+			Logger::WriteMessage("ForkJoin->QuickSort: Start\n");
+			Threading::ForkJoinPool pool(8);
+			std::mt19937 generator(7);
+			std::vector<long> values(1 << 18);
+			for (long& value : values) {
+				value = (long)(generator() % 1000);
+			}
+			std::vector<long> expected(values);
+			std::sort(expected.begin(), expected.end());
+
+			pool.Run([&values]() { ForkJoinTest::QuickSort(values.data(), values.data() + values.size()); });
+			Assert::IsTrue(values == expected);
+			Logger::WriteMessage("ForkJoin->QuickSort: End\n");
+		}
+
+		TEST_METHOD(ForkJoin_ManyChildren) {
+			Logger::WriteMessage("ForkJoin->ManyChildren: Start\n");
+			// More children than the initial deque capacity, the owner grows its deque
+			Threading::ForkJoinPool pool(4, 16);
+			const long NUMBER_CHILDREN = 100;
+			std::atomic<long> executed(0);
+			pool.Run([&executed]() {
+				std::vector<std::unique_ptr<Threading::ForkJoinTask<std::function<void()>>>> children;
+				Threading::ForkJoin scope;
+				for (long i = 0; i < NUMBER_CHILDREN; ++i) {
+					children.emplace_back(new Threading::ForkJoinTask<std::function<void()>>([&executed]() { ++executed; }));
+					scope.Spawn(*children.back());
+				}
+				scope.Sync();
+			});
+			Assert::AreEqual(NUMBER_CHILDREN, executed.load());
+			Logger::WriteMessage("ForkJoin->ManyChildren: End\n");
+		}
+
+		TEST_METHOD(ForkJoin_OutsidePool) {
+			// Without a worker Spawn runs the child immediately
+			long value = 0;
+			Threading::ForkJoinTask child([&value]() { value = 1; });
+			Threading::ForkJoin scope;
+			scope.Spawn(child);
+			Assert::AreEqual(1L, value);
+			scope.Sync();
+			Assert::AreEqual(55L, ForkJoinTest::Fibonacci(10));
+			Logger::WriteMessage("ForkJoin->OutsidePool Passed.\n");
+		}
+	};
+}
\ No newline at end of file
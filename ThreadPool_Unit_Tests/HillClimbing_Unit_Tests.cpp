@@ -0,0 +1,63 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include "HillClimbing.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(HillClimbingUnitTests) {
+	public:
+		TEST_METHOD(ThreadPoolCPP_ActiveThreads) {
+			Logger::WriteMessage("ThreadPoolCPP->ActiveThreads: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			StrandTest::Monitor monitor;
+			const long REPETITION_NUMBER = 32;
+			Assert::AreEqual((std::size_t)8, threadpool.ActiveThreads());
+
+			threadpool.SetActiveThreads(2);
+			Assert::AreEqual((std::size_t)2, threadpool.ActiveThreads());
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.Push(HillClimbingTest::Measure, &monitor, std::chrono::microseconds(500));
+			}
+			threadpool.Wait();
+			Assert::AreEqual(REPETITION_NUMBER, monitor.executed.load());
+			Assert::IsTrue(monitor.maxConcurrent.load() <= 2);
+			Logger::WriteMessage("ThreadPoolCPP->ActiveThreads: Limit Passed\n");
+
+			threadpool.SetActiveThreads(0);
+			Assert::AreEqual((std::size_t)1, threadpool.ActiveThreads());
+			threadpool.SetActiveThreads(64);
+			Assert::AreEqual((std::size_t)8, threadpool.ActiveThreads());
+			Assert::AreEqual((std::uint64_t)REPETITION_NUMBER, threadpool.CompletedTasks());
+			Logger::WriteMessage("ThreadPoolCPP->ActiveThreads: End\n");
+		}
+
+		TEST_METHOD(HillClimbing_Controller) {
+			Logger::WriteMessage("HillClimbing->Controller: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			Threading::HillClimbingSettings settings;
+			settings.minThreads = 2;
+			settings.maxThreads = 6;
+			settings.sampleInterval = std::chrono::milliseconds(5);
+			settings.samplesPerMove = 2;
+			{
+				Threading::HillClimbing<Threading::ThreadPoolCPP> controller(threadpool, settings);
+				Assert::AreEqual((std::size_t)6, controller.Settings().maxThreads);
+				for (long i = 0; i < 2000; ++i) {
+					threadpool.Push(HillClimbingTest::Spin, std::chrono::microseconds(100));
+				}
+				threadpool.Wait();
+
+				auto metrics = controller.GetMetrics();
+				Assert::IsTrue(metrics.samples > 0);
+				Assert::IsFalse(metrics.history.empty());
+				for (const auto& decision : metrics.history) {
+					Assert::IsTrue(decision.threads >= 2 && decision.threads <= 6);
+				}
+				Assert::IsTrue(metrics.activeThreads >= 2 && metrics.activeThreads <= 6);
+			}
+			Logger::WriteMessage("HillClimbing->Controller: End\n");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "HugePageArena.hpp"
+#include "ThreadPoolCPP.hpp"
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(HugePageArenaUnitTests) {
+	public:
+		TEST_METHOD(HugePageArena_Reuse) {
+			Logger::WriteMessage("HugePageArena->Reuse: Start\n");
+			Threading::HugePageArena arena;
+			void* first = arena.Allocate(40);
+			Assert::IsNotNull(first);
+			Assert::AreEqual((std::uintptr_t)0, reinterpret_cast<std::uintptr_t>(first) % alignof(std::max_align_t));
+			arena.Deallocate(first, 40);
+			// Same size class comes back from the free list
+			void* second = arena.Allocate(64);
+			Assert::IsTrue(first == second);
+			void* aligned = arena.Allocate(8, 64);
+			Assert::AreEqual((std::uintptr_t)0, reinterpret_cast<std::uintptr_t>(aligned) % 64);
+			// Too large for a size class, served by operator new
+			void* large = arena.Allocate(arena.ChunkSize());
+			Threading::ArenaStats stats = arena.Stats();
+			Assert::AreEqual((std::size_t)1, stats.chunks);
+			Assert::AreEqual(arena.ChunkSize(), stats.mappedBytes);
+			Assert::AreEqual((std::size_t)128, stats.allocatedBytes);
+			arena.Deallocate(large, arena.ChunkSize());
+			arena.Deallocate(aligned, 8, 64);
+			arena.Deallocate(second, 64);
+			Assert::AreEqual((std::size_t)0, arena.Stats().allocatedBytes);
+			// Without an arena over-aligned types still get their alignment
+			struct alignas(128) Wide {
+				unsigned char bytes[128];
+			};
+			Threading::ArenaAllocator<Wide> fallback;
+			Wide* wide = fallback.allocate(3);
+			Assert::AreEqual((std::uintptr_t)0, reinterpret_cast<std::uintptr_t>(wide) % alignof(Wide));
+			fallback.deallocate(wide, 3);
+			Logger::WriteMessage("HugePageArena->Reuse: End\n");
+		}
+
+		TEST_METHOD(HugePageArena_Trim) {
+			Logger::WriteMessage("HugePageArena->Trim: Start\n");
+			Threading::HugePageArena arena;
+			const std::size_t BLOCK = 64 << 10;
+			void* first = arena.Allocate(BLOCK);
+			void* second = arena.Allocate(BLOCK);
+			void* third = arena.Allocate(BLOCK);
+			static_cast<unsigned char*>(second)[BLOCK - 1] = 1;
+			arena.Deallocate(second, BLOCK);
+			// Live blocks, only the free block's pages after its first one go back, huge page chunks release nothing
+			bool huge = arena.Stats().hugeChunks != 0;
+			std::size_t released = arena.Trim();
+			Assert::AreEqual(huge ? (std::size_t)0 : BLOCK - Threading::HugePageArena::PageSize, released);
+			// Pages released before and not touched since are not counted again
+			Assert::AreEqual((std::size_t)0, arena.Trim());
+			Assert::IsTrue(arena.Allocate(BLOCK) == second);
+			arena.Deallocate(second, BLOCK);
+			arena.Deallocate(third, BLOCK);
+			arena.Deallocate(first, BLOCK);
+			// Nothing live, every carved page goes back and carving restarts at the first block
+			std::size_t full = arena.Trim();
+			Assert::AreEqual(huge ? arena.ChunkSize() : 3 * BLOCK, full);
+			Assert::AreEqual((std::size_t)0, arena.Trim());
+			Assert::IsTrue(arena.Allocate(BLOCK) == first);
+			Assert::AreEqual((std::size_t)1, arena.Stats().chunks);
+			Assert::AreEqual(released + full, arena.Stats().trimmedBytes);
+			Logger::WriteMessage("HugePageArena->Trim: End\n");
+		}
+
+		TEST_METHOD(HugePageArena_ThreadPool) {
+			Logger::WriteMessage("HugePageArena->ThreadPool: Start\n");
+			Threading::ThreadPoolCPPSettings settings;
+			settings.hugePageArena = true;
+			Threading::ThreadPoolCPP threadpool(4, settings);
+			const long REPETITION_NUMBER = 1000;
+			const long COUNT = 100;
+			std::atomic<long> total(0);
+
+			threadpool.Pause();
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.Push(ArenaTest::Scratch, &total, COUNT);
+			}
+			Threading::ArenaStats stats = threadpool.GetArenaStats();
+			Assert::IsTrue(stats.chunks >= 1);
+			Assert::IsTrue(stats.allocatedBytes > 0);
+			threadpool.Resume();
+			threadpool.Wait();
+
+			Assert::AreEqual(REPETITION_NUMBER * COUNT * (COUNT + 1) / 2, total.load());
+			Assert::AreEqual((std::size_t)0, threadpool.QueuedTasks());
+			// Scratch outside a worker falls back to operator new
+			Assert::IsNull(Threading::ThreadPoolCPP::ScratchAllocator<long>().Arena());
+			Logger::WriteMessage("HugePageArena->ThreadPool: End\n");
+		}
+
+		TEST_METHOD(HugePageArena_IdleTrim) {
+			Logger::WriteMessage("HugePageArena->IdleTrim: Start\n");
+			Threading::ThreadPoolCPPSettings settings;
+			settings.hugePageArena = true;
+			settings.stackSize = 256 << 10;
+			settings.idleTrim = std::chrono::milliseconds(20);
+			Threading::ThreadPoolCPP threadpool(2, settings);
+			std::atomic<long> total(0);
+			for (long i = 0; i < 100; ++i) {
+				threadpool.Push(ArenaTest::Scratch, &total, 1000);
+			}
+			threadpool.Wait();
+
+			Threading::MemoryStats stats = threadpool.MemoryUsage();
+			Assert::AreEqual((std::size_t)2, stats.threads);
+			Assert::AreEqual(2 * Threading::WorkerThread::StackSize(settings.stackSize), stats.stackBytes);
+			Assert::IsTrue(stats.arenaMappedBytes >= 2 * Threading::HugePageArena::DefaultChunkSize);
+			Assert::IsTrue(stats.bookkeepingBytes > 0);
+			// Workers that ran tasks and then idled for idleTrim release their scratch arenas
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (threadpool.MemoryUsage().arenaTrimmedBytes == 0 && std::chrono::steady_clock::now() < deadline) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+			Assert::IsTrue(threadpool.MemoryUsage().arenaTrimmedBytes > 0);
+			Logger::WriteMessage("HugePageArena->IdleTrim: End\n");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "IoReactor.hpp"
+
+#if defined(__linux__)
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(IoReactorUnitTests) {
+	public:
+		TEST_METHOD(IoReactor_Pipe) {
+			Logger::WriteMessage("IoReactor->Pipe: Start\n");
+			const long REPETITION_NUMBER = 100;
+			Threading::ThreadPoolCPPSettings settings;
+			settings.maxSpareThreads = 1;
+			Threading::ThreadPoolCPP threadpool(2, settings);
+			int fds[2];
+			Assert::AreEqual(0, pipe(fds));
+			std::atomic<long> received(0);
+			{
+				Threading::IoReactor reactor(threadpool);
+				Assert::IsTrue(reactor.Add(fds[0], EPOLLIN, [&reactor, &received](int fd, std::uint32_t events) {
+					char buffer[64];
+					if (events & EPOLLIN) {
+						ssize_t count = read(fd, buffer, sizeof(buffer));
+						received += count > 0 ? (long)count : 0;
+					}
+					reactor.Rearm(fd);
+				}));
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					char byte = (char)i;
+					Assert::AreEqual((ssize_t)1, write(fds[1], &byte, 1));
+				}
+				while (received.load() != REPETITION_NUMBER) {
+					std::this_thread::yield();
+				}
+				Assert::IsTrue(reactor.Remove(fds[0]));
+				Assert::IsFalse(reactor.Rearm(fds[0]));
+				// The last handler may still be inside Rearm, Stop waits for it
+				reactor.Stop();
+				threadpool.Wait();
+			}
+			close(fds[0]);
+			close(fds[1]);
+			Assert::AreEqual(REPETITION_NUMBER, received.load());
+			Logger::WriteMessage("IoReactor->Pipe: End\n");
+		}
+
+		TEST_METHOD(IoReactor_Sockets) {
+			Logger::WriteMessage("IoReactor->Sockets: Start\n");
+			const long REPETITION_NUMBER = 1000;
+			Threading::ThreadPoolCPPSettings settings;
+			settings.maxSpareThreads = 2;
+			Threading::ThreadPoolCPP threadpool(2, settings);
+			int fds[2];
+			Assert::AreEqual(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+			std::atomic<long> pongs(0);
+			{
+				// A poller more than the spare threads would take a worker away from tasks
+				Assert::ExpectException<std::invalid_argument>([&threadpool]() { Threading::IoReactor reactor(threadpool, 3); });
+				Threading::IoReactor reactor(threadpool, 2);
+				// Each side answers every message it reads, so the two ends play ping-pong through the reactor
+				auto echo = [&reactor, &pongs, REPETITION_NUMBER](int fd, std::uint32_t) {
+					long value = 0;
+					// Blocking descriptors, read once and let the rearm report anything still buffered
+					if (read(fd, &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+						if (value < REPETITION_NUMBER) {
+							++value;
+							ssize_t written = write(fd, &value, sizeof(value));
+							(void)written;
+						}
+						pongs.store(value);
+					}
+					reactor.Rearm(fd);
+				};
+				for (int fd : fds) {
+					Assert::IsTrue(reactor.Add(fd, EPOLLIN, echo));
+				}
+				long start = 0;
+				Assert::AreEqual((ssize_t)sizeof(start), write(fds[0], &start, sizeof(start)));
+				while (pongs.load() != REPETITION_NUMBER) {
+					std::this_thread::yield();
+				}
+				reactor.Stop();
+				threadpool.Wait();
+			}
+			close(fds[0]);
+			close(fds[1]);
+			Assert::AreEqual(REPETITION_NUMBER, pongs.load());
+			Logger::WriteMessage("IoReactor->Sockets: End\n");
+		}
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include "ParallelAlgorithms.hpp"
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(ParallelAlgorithmsUnitTests) {
+	public:
+		TEST_METHOD(ParallelFor_Execution) {
+			Threading::ThreadPoolCPP threadpool(8);
+			std::vector<long> values(1000, 0);
+			Threading::ParallelFor(threadpool, 0, values.size(), [&values](std::size_t i) { values[i] = (long)i; }, 7);
+			for (std::size_t i = 0; i < values.size(); ++i) {
+				Assert::AreEqual((long)i, values[i]);
+			}
+			Logger::WriteMessage("ParallelFor->Execution Passed.\n");
+		}
+
+		TEST_METHOD(ParallelSort_Execution) {
+			Logger::WriteMessage("ParallelSort->Execution: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			std::default_random_engine randomEngine;
+			std::uniform_int_distribution<long> uid(0, 1000);
+
+			for (std::size_t size : { 0, 1, 17, 1000, 100000 }) {
+				std::vector<long> testValues(size);
+				for (long& value : testValues) {
+					value = uid(randomEngine);
+				}
+				std::vector<long> expectedValues(testValues);
+				std::sort(expectedValues.begin(), expectedValues.end());
+				// A small cutoff forces several merge rounds
+				Threading::ParallelSort(threadpool, testValues.begin(), testValues.end(), std::less<>(), 64);
+				Assert::IsTrue(expectedValues == testValues);
+			}
+			Logger::WriteMessage("ParallelSort->Execution: Sizes Passed\n");
+
+			// Custom comparison with many equal keys
+			std::vector<long> testValues(20000);
+			for (long& value : testValues) {
+				value = uid(randomEngine) % 16;
+			}
+			std::vector<long> expectedValues(testValues);
+			std::sort(expectedValues.begin(), expectedValues.end(), std::greater<>());
+			Threading::ParallelSort(threadpool, testValues.begin(), testValues.end(), std::greater<>(), 100);
+			Assert::IsTrue(expectedValues == testValues);
+			Logger::WriteMessage("ParallelSort->Execution: Equal Keys Passed\n");
+
+			// Merge parts split along the output, so a range that sorts entirely before the other is not one part's work
+			std::vector<long> low(1000, 1);
+			std::vector<long> high(1000, 2);
+			Assert::AreEqual((std::size_t)500, Threading::DetailAlgorithms::MergeSplit(low.begin(), low.end(), high.begin(), high.end(), 500, std::less<>()));
+			Assert::AreEqual((std::size_t)1000, Threading::DetailAlgorithms::MergeSplit(low.begin(), low.end(), high.begin(), high.end(), 1500, std::less<>()));
+			Assert::AreEqual((std::size_t)0, Threading::DetailAlgorithms::MergeSplit(high.begin(), high.end(), low.begin(), low.end(), 500, std::less<>()));
+			// Ties go to the first range
+			Assert::AreEqual((std::size_t)700, Threading::DetailAlgorithms::MergeSplit(low.begin(), low.end(), low.begin(), low.end(), 700, std::less<>()));
+			Assert::AreEqual((std::size_t)1000, Threading::DetailAlgorithms::MergeSplit(low.begin(), low.end(), low.begin(), low.end(), 1200, std::less<>()));
+
+			// Each half sorted, one far below the other
+			testValues.resize(100000);
+			for (std::size_t i = 0; i < testValues.size(); ++i) {
+				testValues[i] = i < testValues.size() / 2 ? uid(randomEngine) : uid(randomEngine) + 2000;
+			}
+			expectedValues = testValues;
+			std::sort(expectedValues.begin(), expectedValues.end());
+			Threading::ParallelSort(threadpool, testValues.begin(), testValues.end(), std::less<>(), 64);
+			Assert::IsTrue(expectedValues == testValues);
+			Logger::WriteMessage("ParallelSort->Execution: Halves Passed\n");
+
+			// Element types without a default constructor
+			std::vector<SortTest::Keyed> keyedValues;
+			for (long i = 0; i < 10000; ++i) {
+				keyedValues.emplace_back(uid(randomEngine));
+			}
+			std::vector<SortTest::Keyed> expectedKeyed(keyedValues);
+			std::sort(expectedKeyed.begin(), expectedKeyed.end());
+			Threading::ParallelSort(threadpool, keyedValues.begin(), keyedValues.end(), std::less<>(), 64);
+			Assert::IsTrue(expectedKeyed == keyedValues);
+			Logger::WriteMessage("ParallelSort->Execution: End\n");
+		}
+
+		TEST_METHOD(ParallelScan_Execution) {
+			Logger::WriteMessage("ParallelScan->Execution: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			std::default_random_engine randomEngine;
+			std::uniform_int_distribution<long> uid(-100, 100);
+
+			for (std::size_t size : { 0, 1, 17, 1000, 100000 }) {
+				std::vector<long> input(size);
+				for (long& value : input) {
+					value = uid(randomEngine);
+				}
+				std::vector<long> expected(size);
+				std::vector<long> test(size);
+
+				std::partial_sum(input.begin(), input.end(), expected.begin());
+				Threading::ParallelInclusiveScan(threadpool, input.begin(), input.end(), test.begin(), std::plus<>(), 64);
+				Assert::IsTrue(expected == test);
+
+				if (size > 0) {
+					expected[0] = 5;
+					std::partial_sum(input.begin(), input.end() - 1, expected.begin() + 1);
+					for (std::size_t i = 1; i < size; ++i) {
+						expected[i] += 5;
+					}
+				}
+				// In place
+				test = input;
+				Threading::ParallelExclusiveScan(threadpool, test.begin(), test.end(), test.begin(), 5L, std::plus<>(), 64);
+				Assert::IsTrue(expected == test);
+			}
+			Logger::WriteMessage("ParallelScan->Execution: End\n");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include "Pipeline.hpp"
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(PipelineUnitTests) {
+	public:
+		using pipeline_type = Threading::Pipeline<PipelineTest::Token>;
+
+		TEST_METHOD(Pipeline_Fusion) {
+			pipeline_type pipeline([](PipelineTest::Token&) { return false; }, 4);
+			pipeline.AddStage(pipeline_type::Mode::Parallel, [](PipelineTest::Token&) {})
+				.AddStage(pipeline_type::Mode::Parallel, [](PipelineTest::Token&) {})
+				.AddStage(pipeline_type::Mode::SerialInOrder, [](PipelineTest::Token&) {})
+				.AddStage(pipeline_type::Mode::Parallel, [](PipelineTest::Token&) {});
+			Assert::AreEqual((std::size_t)3, pipeline.Steps());
+
+			Threading::ThreadPoolCPP threadpool(4);
+			Assert::AreEqual((std::uint64_t)0, pipeline.Run(threadpool));
+			Logger::WriteMessage("Pipeline->Fusion Passed.\n");
+		}
+
+		TEST_METHOD(Pipeline_SerialInOrder) {
+			Logger::WriteMessage("Pipeline->SerialInOrder: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			const long REPETITION_NUMBER = 5000;
+			const std::size_t MAX_TOKENS = 8;
+			std::atomic<long> inFlight(0);
+			std::atomic<long> maxInFlight(0);
+			long produced = 0;
+			std::vector<long> output;
+
+			for (bool cheap : { false, true }) {
+				produced = 0;
+				output.clear();
+				pipeline_type pipeline([&](PipelineTest::Token& token) {
+					if (produced == REPETITION_NUMBER) {
+						return false;
+					}
+					token.value = produced++;
+					long current = ++inFlight;
+					long previous = maxInFlight.load();
+					while (current > previous && !maxInFlight.compare_exchange_weak(previous, current)) {
+
+					}
+					return true;
+				}, MAX_TOKENS);
+				pipeline.AddStage(pipeline_type::Mode::Parallel, [](PipelineTest::Token& token) { token.value *= 2; })
+					.AddStage(pipeline_type::Mode::SerialInOrder, [&](PipelineTest::Token& token) { output.push_back(token.value); }, cheap)
+					.AddStage(pipeline_type::Mode::Parallel, [&](PipelineTest::Token&) { --inFlight; });
+
+				Assert::AreEqual((std::uint64_t)REPETITION_NUMBER, pipeline.Run(threadpool));
+				Assert::AreEqual((std::size_t)REPETITION_NUMBER, output.size());
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					Assert::AreEqual(i * 2, output[i]);
+				}
+				Assert::IsTrue(maxInFlight.load() <= (long)MAX_TOKENS);
+			}
+			Logger::WriteMessage("Pipeline->SerialInOrder: End\n");
+		}
+
+		TEST_METHOD(Pipeline_SerialOutOfOrder) {
+			Logger::WriteMessage("Pipeline->SerialOutOfOrder: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			const long REPETITION_NUMBER = 5000;
+			long produced = 0;
+			long expectedValue = 0;
+			long testValue = 0;
+			StrandTest::Monitor monitor;
+
+			pipeline_type pipeline([&](PipelineTest::Token& token) {
+				if (produced == REPETITION_NUMBER) {
+					return false;
+				}
+				token.value = produced++;
+				return true;
+			}, 16);
+			pipeline.AddStage(pipeline_type::Mode::Parallel, [](PipelineTest::Token& token) { token.value += 1; })
+				.AddStage(pipeline_type::Mode::SerialOutOfOrder, [&](PipelineTest::Token& token) {
+					StrandTest::Enter(&monitor);
+					testValue += token.value;
+				});
+
+			// Pipelines can be run repeatedly
+			for (long run = 0; run < 2; ++run) {
+				produced = 0;
+				Assert::AreEqual((std::uint64_t)REPETITION_NUMBER, pipeline.Run(threadpool));
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					expectedValue += i + 1;
+				}
+				Assert::AreEqual(expectedValue, testValue);
+			}
+			Assert::AreEqual(1L, monitor.maxConcurrent.load());
+			Logger::WriteMessage("Pipeline->SerialOutOfOrder: End\n");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "PoolPartition.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(PoolPartitionUnitTests) {
+	public:
+		static bool WaitFor(std::function<bool()> condition, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+			auto deadline = std::chrono::steady_clock::now() + timeout;
+			while (!condition()) {
+				if (std::chrono::steady_clock::now() >= deadline) {
+					return false;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			return true;
+		}
+
+		TEST_METHOD(PoolPartition_Assignment) {
+			Logger::WriteMessage("PoolPartition->Assignment: Start\n");
+			Threading::PoolPartition partition({ 0, 1, 2, 3 });
+			Threading::PartitionSettings latency;
+			latency.guaranteedCores = 2;
+			Threading::PartitionSettings throughput;
+			throughput.guaranteedCores = 2;
+			throughput.borrowableCores = 2;
+			Threading::PartitionId first = partition.AddPool(latency);
+			Threading::PartitionId second = partition.AddPool(throughput);
+			Assert::AreEqual((std::size_t)2, partition.Pools());
+
+			Threading::PartitionMetrics metrics = partition.GetMetrics(first);
+			Assert::IsTrue(metrics.ownedCores == std::vector<int>({ 0, 1 }));
+			Assert::AreEqual((std::size_t)2, metrics.activeThreads);
+			metrics = partition.GetMetrics(second);
+			Assert::IsTrue(metrics.ownedCores == std::vector<int>({ 2, 3 }));
+			// One worker per core it may hold, the borrowing workers stay parked
+			Assert::AreEqual((std::size_t)4, partition.Pool(second).Size());
+			Assert::AreEqual((std::size_t)2, metrics.activeThreads);
+			Assert::ExpectException<std::invalid_argument>([&partition, &latency]() { partition.AddPool(latency); });
+			Assert::ExpectException<std::out_of_range>([&partition]() { partition.Pool(2); });
+			Assert::ExpectException<std::out_of_range>([&partition]() { partition.GetMetrics(2); });
+			Logger::WriteMessage("PoolPartition->Assignment: End\n");
+		}
+
+		TEST_METHOD(PoolPartition_AddWhileLent) {
+			Logger::WriteMessage("PoolPartition->AddWhileLent: Start\n");
+			Threading::PoolPartition partition({ 0, 1, 2, 3 });
+			Threading::PartitionSettings throughput;
+			throughput.guaranteedCores = 2;
+			throughput.borrowableCores = 2;
+			Threading::PartitionId bulk = partition.AddPool(throughput);
+			Threading::ThreadPoolCPP& bulkPool = partition.Pool(bulk);
+			for (long i = 0; i < 500; ++i) {
+				bulkPool.Push(HillClimbingTest::Spin, std::chrono::microseconds(1000));
+			}
+			Assert::IsTrue(WaitFor([&]() { return partition.GetMetrics(bulk).borrowedCores == 2; }));
+
+			// Both unassigned cores are on loan, the new pool takes them back instead of failing and keeps them
+			Threading::PartitionSettings latency;
+			latency.guaranteedCores = 2;
+			latency.lendIdle = false;
+			Threading::PartitionId fast = partition.AddPool(latency);
+			Assert::IsTrue(partition.GetMetrics(fast).ownedCores.size() == 2);
+			Assert::AreEqual((std::size_t)2, partition.Pool(fast).ActiveThreads());
+			Assert::AreEqual((std::size_t)0, partition.GetMetrics(bulk).borrowedCores);
+			Assert::AreEqual((std::size_t)2, bulkPool.ActiveThreads());
+			Assert::ExpectException<std::invalid_argument>([&partition, &latency]() { partition.AddPool(latency); });
+			bulkPool.Wait();
+			Logger::WriteMessage("PoolPartition->AddWhileLent: End\n");
+		}
+
+		TEST_METHOD(PoolPartition_ReclaimWhileRunning) {
+			Logger::WriteMessage("PoolPartition->ReclaimWhileRunning: Start\n");
+			Threading::PoolPartition partition({ 0, 1, 2, 3 });
+			Threading::PartitionSettings latency;
+			latency.guaranteedCores = 2;
+			Threading::PartitionSettings throughput;
+			throughput.guaranteedCores = 2;
+			throughput.borrowableCores = 1;
+			Threading::PartitionId fast = partition.AddPool(latency);
+			Threading::PartitionId bulk = partition.AddPool(throughput);
+			Threading::ThreadPoolCPP& fastPool = partition.Pool(fast);
+			Threading::ThreadPoolCPP& bulkPool = partition.Pool(bulk);
+
+			// Every throughput worker runs a task that outlasts the loan, the third on the core borrowed from the latency pool
+			std::atomic<long> started(0);
+			std::atomic<bool> release(false);
+			for (long i = 0; i < 4; ++i) {
+				bulkPool.Push([&started, &release]() {
+					++started;
+					while (!release.load()) {
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+				});
+			}
+			bool borrowed = WaitFor([&]() { return partition.GetMetrics(bulk).borrowedCores == 1 && started.load() == 3; });
+			int lent = bulkPool.WorkerAffinity(2);
+
+			// The owner takes its core back and the parked worker leaves it while its task still runs
+			fastPool.Pause();
+			fastPool.Push(HillClimbingTest::Spin, std::chrono::microseconds(100));
+			// Metrics are read under the partition lock, so both pools have been updated once the owner shows its core back
+			bool reclaimed = WaitFor([&]() { return partition.GetMetrics(fast).activeThreads == 2; }, std::chrono::milliseconds(1000));
+			std::size_t active = partition.GetMetrics(bulk).activeThreads;
+			int parked = bulkPool.WorkerAffinity(2);
+			// Read before the release, once the latency pool is idle again the controller may lend core 1 out a second time
+			int fastFirst = fastPool.WorkerAffinity(0);
+			int fastSecond = fastPool.WorkerAffinity(1);
+			long running = started.load();
+			// Released before asserting, the threadpools could not be destroyed with the tasks still held
+			release.store(true);
+			fastPool.Resume();
+			fastPool.Wait();
+			bulkPool.Wait();
+			// Checked first, without the loan the affinities below say nothing
+			Assert::IsTrue(borrowed);
+			Assert::AreEqual(1, lent);
+			Assert::IsTrue(reclaimed);
+			Assert::AreEqual((std::size_t)2, active);
+			Assert::AreEqual(2, parked);
+			Assert::AreEqual(0, fastFirst);
+			Assert::AreEqual(1, fastSecond);
+			Assert::AreEqual(3L, running);
+			Assert::AreEqual(4L, started.load());
+			Logger::WriteMessage("PoolPartition->ReclaimWhileRunning: End\n");
+		}
+
+		TEST_METHOD(PoolPartition_LendAndReclaim) {
+			Logger::WriteMessage("PoolPartition->LendAndReclaim: Start\n");
+			Threading::PoolPartition partition({ 0, 1, 2, 3, 4 });
+			Threading::PartitionSettings latency;
+			latency.guaranteedCores = 2;
+			Threading::PartitionSettings throughput;
+			throughput.guaranteedCores = 2;
+			throughput.borrowableCores = 2;
+			Threading::PartitionId fast = partition.AddPool(latency);
+			Threading::PartitionId bulk = partition.AddPool(throughput);
+			Threading::ThreadPoolCPP& fastPool = partition.Pool(fast);
+			Threading::ThreadPoolCPP& bulkPool = partition.Pool(bulk);
+
+			// The unassigned core and one idle latency core go to the busy throughput pool, the latency pool keeps one
+			for (long i = 0; i < 500; ++i) {
+				bulkPool.Push(HillClimbingTest::Spin, std::chrono::microseconds(1000));
+			}
+			Assert::IsTrue(WaitFor([&]() { return partition.GetMetrics(bulk).borrowedCores == 2; }));
+			Assert::AreEqual((std::size_t)4, bulkPool.ActiveThreads());
+			Assert::AreEqual((std::size_t)1, partition.GetMetrics(fast).lentCores);
+			Assert::AreEqual((std::size_t)1, fastPool.ActiveThreads());
+
+			// Queued work on the owner brings its core back within a few controller periods
+			fastPool.Pause();
+			fastPool.Push(HillClimbingTest::Spin, std::chrono::microseconds(100));
+			fastPool.Push(HillClimbingTest::Spin, std::chrono::microseconds(100));
+			Assert::IsTrue(WaitFor([&]() { return fastPool.ActiveThreads() == 2; }, std::chrono::milliseconds(1000)));
+			Assert::AreEqual((std::size_t)0, partition.GetMetrics(fast).lentCores);
+			Assert::AreEqual((std::uint64_t)1, partition.GetMetrics(fast).reclaims);
+			Assert::AreEqual((std::size_t)3, bulkPool.ActiveThreads());
+			fastPool.Resume();
+			fastPool.Wait();
+
+			// Once the throughput pool runs dry its borrowed cores go back
+			bulkPool.Wait();
+			Assert::IsTrue(WaitFor([&]() { return partition.GetMetrics(bulk).borrowedCores == 0; }));
+			Assert::AreEqual((std::size_t)2, fastPool.ActiveThreads());
+			Assert::IsTrue(partition.GetMetrics(bulk).loans >= 2);
+			Logger::WriteMessage("PoolPartition->LendAndReclaim: End\n");
+		}
+	};
+}
\ No newline at end of file
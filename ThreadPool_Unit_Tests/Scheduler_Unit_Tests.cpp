@@ -0,0 +1,104 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include "Scheduler.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(SchedulerUnitTests) {
+	public:
+		TEST_METHOD(Scheduler_Schedule) {
+			Logger::WriteMessage("Scheduler->Schedule: Start\n");
+			Threading::ThreadPoolCPP threadpool(4);
+			auto scheduler = Threading::MakeScheduler(threadpool);
+			Assert::IsTrue(scheduler == scheduler.schedule().get_completion_scheduler());
+
+			// The continuation runs on a worker of the threadpool and its result is sent on
+			auto sender = Threading::Then(scheduler.schedule(), []() { return Threading::ThreadPoolCPP::CurrentWorker().threadpool; });
+			auto result = Threading::SyncWait(Threading::Then(sender, [](Threading::ThreadPoolCPP* worker) { return worker != nullptr ? 42 : 0; }));
+			Assert::IsTrue(result.has_value());
+			Assert::AreEqual(42, std::get<0>(*result));
+			Assert::IsTrue(Threading::SyncWait(sender).value() == std::make_tuple(&threadpool));
+
+			// Exceptions thrown by a continuation complete with set_error and SyncWait rethrows them
+			auto failing = Threading::Then(scheduler.schedule(), []() -> int { throw std::runtime_error("failed"); });
+			Assert::ExpectException<std::runtime_error>([&failing]() { Threading::SyncWait(failing); });
+			Logger::WriteMessage("Scheduler->Schedule: End\n");
+		}
+
+		TEST_METHOD(Scheduler_Bulk) {
+			Logger::WriteMessage("Scheduler->Bulk: Start\n");
+			Threading::ThreadPoolCPP threadpool(4);
+			auto scheduler = Threading::MakeScheduler(threadpool);
+			const std::size_t SHAPE = 10000;
+			std::vector<long> values(SHAPE, 0);
+
+			// Values of the predecessor reach every index and are sent on once all chunks ran
+			auto sender = Threading::Bulk(Threading::Then(scheduler.schedule(), []() { return 3L; }), SHAPE, [&values](std::size_t i, long factor) { values[i] = (long)i * factor; });
+			auto result = Threading::SyncWait(Threading::Then(sender, [&values](long factor) { return values.back() / factor; }));
+			Assert::AreEqual((long)SHAPE - 1, std::get<0>(result.value()));
+			for (std::size_t i = 0; i < SHAPE; ++i) {
+				Assert::AreEqual((long)i * 3, values[i]);
+			}
+			// Chunks go through one PushBatch, far fewer tasks than indices
+			Assert::IsTrue(threadpool.CompletedTasks() < 2 + SHAPE / 16);
+
+			std::atomic<long> ran(0);
+			auto empty = Threading::Bulk(scheduler.schedule(), 0, [&ran](std::size_t) { ++ran; });
+			Assert::IsTrue(Threading::SyncWait(empty).has_value());
+			Assert::AreEqual(0L, ran.load());
+
+			// The throwing chunk stops, the others still run and the first exception is the error
+			auto failing = Threading::Bulk(scheduler.schedule(), SHAPE, [&ran](std::size_t i) {
+				++ran;
+				if (i == SHAPE / 2) {
+					throw std::out_of_range("bulk");
+				}
+			});
+			Assert::ExpectException<std::out_of_range>([&failing]() { Threading::SyncWait(failing); });
+			Assert::IsTrue(ran.load() > (long)SHAPE / 2 && ran.load() <= (long)SHAPE);
+			Logger::WriteMessage("Scheduler->Bulk: End\n");
+		}
+
+		TEST_METHOD(Scheduler_AnyBackend) {
+			Logger::WriteMessage("Scheduler->AnyBackend: Start\n");
+			SchedulerTest::InlinePool pool;
+			auto scheduler = Threading::MakeScheduler(pool);
+			std::vector<long> values(100, 0);
+			auto sender = Threading::Bulk(scheduler.schedule(), values.size(), [&values](std::size_t i) { values[i] = 1; });
+			Assert::IsTrue(Threading::SyncWait(sender).has_value());
+			for (long value : values) {
+				Assert::AreEqual(1L, value);
+			}
+			// One Push for schedule, then one per chunk since the backend has no PushBatch
+			Assert::IsTrue(pool.pushed > 1);
+			Logger::WriteMessage("Scheduler->AnyBackend: End\n");
+		}
+
+		TEST_METHOD(Scheduler_BulkPushFailure) {
+			Logger::WriteMessage("Scheduler->BulkPushFailure: Start\n");
+			// schedule takes the first push and two chunks the next, pushing the third chunk throws
+			SchedulerTest::DeferredPool pool(3);
+			std::size_t values = 0;
+			std::size_t errors = 0;
+			std::atomic<long> executed(0);
+			auto sender = Threading::Bulk(Threading::MakeScheduler(pool).schedule(), 1000, [&executed](std::size_t) { executed.fetch_add(1); });
+			auto operation = sender.connect(SchedulerTest::CountingReceiver{ &values, &errors });
+			operation.start();
+			pool.Step();
+			// The failed push does not complete the receiver while pushed chunks are still to run
+			Assert::AreEqual((std::size_t)3, pool.pushed);
+			Assert::AreEqual((std::size_t)0, errors);
+			pool.Step();
+			// The last pushed chunk completed the receiver once, with the push error
+			Assert::IsTrue(executed.load() > 0 && executed.load() < 1000);
+			Assert::AreEqual((std::size_t)0, values);
+			Assert::AreEqual((std::size_t)1, errors);
+			Logger::WriteMessage("Scheduler->BulkPushFailure: End\n");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "SharedWorkQueue.hpp"
+
+#if !defined(_WIN32)
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(SharedWorkQueueUnitTests) {
+	public:
+		TEST_METHOD(SharedWorkQueue_Ring) {
+			Logger::WriteMessage("SharedWorkQueue->Ring: Start\n");
+			std::string name = "/threadpool_ring_" + std::to_string(getpid());
+			Threading::SharedWorkQueue queue = Threading::SharedWorkQueue::Create(name, 6, sizeof(long));
+			Threading::SharedWorkQueue other = Threading::SharedWorkQueue::Open(name);
+			Threading::SharedWorkQueue::Unlink(name);
+			Assert::AreEqual((std::size_t)8, queue.Capacity());
+
+			for (long i = 0; i < 8; ++i) {
+				Assert::IsTrue(queue.Push(1, i));
+			}
+			// Full, and payloads larger than a slot are refused
+			Assert::IsFalse(queue.Push(1, 8L));
+			Assert::IsFalse(queue.Push(1, name.data(), name.size()));
+			Assert::AreEqual((std::size_t)8, other.Size());
+
+			// The second mapping sees the same ring in FIFO order
+			for (long i = 0; i < 8; ++i) {
+				Threading::HandlerId handler = 0;
+				long value = -1;
+				std::size_t size = 0;
+				Assert::IsTrue(other.Pop(handler, &value, size));
+				Assert::AreEqual((Threading::HandlerId)1, handler);
+				Assert::AreEqual(sizeof(long), size);
+				Assert::AreEqual(i, value);
+			}
+			Threading::HandlerId handler;
+			long value;
+			std::size_t size;
+			Assert::IsFalse(queue.Pop(handler, &value, size));
+			Logger::WriteMessage("SharedWorkQueue->Ring: End\n");
+		}
+
+		TEST_METHOD(SharedWorkQueue_Restart) {
+			Logger::WriteMessage("SharedWorkQueue->Restart: Start\n");
+			const long REPETITION_NUMBER = 100;
+			const Threading::HandlerId ADD = 1;
+			const Threading::HandlerId LATE = 2;
+			std::string name = "/threadpool_restart_" + std::to_string(getpid());
+			std::atomic<long> executed(0);
+			Threading::ThreadPoolCPPSettings settings;
+			settings.maxSpareThreads = 2;
+			Threading::ThreadPoolCPP threadpool(2, settings);
+			{
+				Threading::SharedWorkQueue queue = Threading::SharedWorkQueue::Create(name, 8, sizeof(long));
+				Threading::SharedWorkQueue::Unlink(name);
+				// Without a spare thread the poller would take a worker away for good
+				Threading::ThreadPoolCPP starved(1);
+				Assert::ExpectException<std::invalid_argument>([&starved, &queue]() { Threading::SharedQueuePump pump(starved, queue); });
+				Threading::SharedQueuePump pump(threadpool, queue);
+				pump.Register(ADD, [&executed](const void*, std::size_t) { ++executed; });
+				// Both pollers are queued before either runs, only the second Start's may poll
+				threadpool.Pause();
+				pump.Start();
+				pump.Stop();
+				pump.Start();
+				threadpool.Resume();
+				// Handlers may be added while the poller runs
+				pump.Register(LATE, [&executed](const void*, std::size_t) { ++executed; });
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					while (!queue.Push(i % 2 ? ADD : LATE, i)) {
+						std::this_thread::yield();
+					}
+				}
+				while (executed.load() != REPETITION_NUMBER) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				// No poller touches the queue once Stop returns, so it can be destroyed right away
+				pump.Stop();
+			}
+			threadpool.Wait();
+			Assert::AreEqual(REPETITION_NUMBER, executed.load());
+			Logger::WriteMessage("SharedWorkQueue->Restart: End\n");
+		}
+
+		TEST_METHOD(SharedWorkQueue_Processes) {
+			Logger::WriteMessage("SharedWorkQueue->Processes: Start\n");
+			const long REPETITION_NUMBER = 2000;
+			const Threading::HandlerId ADD = 7;
+			std::string name = "/threadpool_processes_" + std::to_string(getpid());
+			Threading::SharedWorkQueue queue = Threading::SharedWorkQueue::Create(name, 256, sizeof(long));
+			// Results from both processes, in a mapping that survives fork
+			struct Results {
+				std::atomic<long> sum;
+				std::atomic<long> executed[2];
+				std::atomic<bool> stop;
+			};
+			void* memory = mmap(nullptr, sizeof(Results), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+			Assert::IsTrue(memory != MAP_FAILED);
+			Results* results = new (memory) Results();
+
+			// Fork before any threadpool exists, the child opens the queue by name like an unrelated process would
+			pid_t child = fork();
+			if (child == 0) {
+				{
+					Threading::SharedWorkQueue shared = Threading::SharedWorkQueue::Open(name);
+					Threading::ThreadPoolCPPSettings settings;
+					settings.maxSpareThreads = 1;
+					Threading::ThreadPoolCPP threadpool(2, settings);
+					Threading::SharedQueuePump pump(threadpool, shared);
+					pump.Register(ADD, [results](const void* payload, std::size_t) { results->sum += *static_cast<const long*>(payload); ++results->executed[1]; });
+					pump.Start();
+					while (!results->stop.load()) {
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+					pump.Stop();
+					threadpool.Wait();
+				}
+				_exit(0);
+			}
+			Assert::IsTrue(child > 0);
+
+			{
+				Threading::ThreadPoolCPPSettings settings;
+				settings.maxSpareThreads = 1;
+				Threading::ThreadPoolCPP threadpool(2, settings);
+				Threading::SharedQueuePump pump(threadpool, queue);
+				pump.Register(ADD, [results](const void* payload, std::size_t) { results->sum += *static_cast<const long*>(payload); ++results->executed[0]; });
+				pump.Start();
+				for (long i = 1; i <= REPETITION_NUMBER; ++i) {
+					while (!queue.Push(ADD, i)) {
+						std::this_thread::yield();
+					}
+				}
+				while (results->executed[0].load() + results->executed[1].load() != REPETITION_NUMBER) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				pump.Stop();
+				threadpool.Wait();
+				Assert::AreEqual((std::uint64_t)0, pump.Unhandled());
+			}
+			results->stop.store(true);
+			int status = 0;
+			Assert::AreEqual(child, waitpid(child, &status, 0));
+			Assert::IsTrue(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+			Threading::SharedWorkQueue::Unlink(name);
+
+			Assert::AreEqual(REPETITION_NUMBER * (REPETITION_NUMBER + 1) / 2, results->sum.load());
+			Assert::AreEqual(REPETITION_NUMBER, results->executed[0].load() + results->executed[1].load());
+			munmap(memory, sizeof(Results));
+			Logger::WriteMessage("SharedWorkQueue->Processes: End\n");
+		}
+	};
+}
+#endif
\ No newline at end of file
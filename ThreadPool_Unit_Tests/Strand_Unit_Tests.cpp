@@ -0,0 +1,72 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include "Strand.hpp"
+#include <memory>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(StrandUnitTests) {
+	public:
+		TEST_METHOD(Strand_Constructor) {
+			Threading::ThreadPoolCPP threadpool(8);
+			{
+				Threading::Strand<Threading::ThreadPoolCPP> strand(threadpool);
+				Assert::IsTrue(strand.Empty());
+				Logger::WriteMessage("Strand->Constructor Passed.\n");
+			}
+			Logger::WriteMessage("Strand->Destructor Passed.\n");
+		}
+
+		TEST_METHOD(Strand_Order) {
+			Logger::WriteMessage("Strand->Order: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			Threading::Strand<Threading::ThreadPoolCPP> strand(threadpool);
+			const long REPETITION_NUMBER = 10000;
+			std::vector<long> order;
+			order.reserve(REPETITION_NUMBER);
+
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				strand.Push(StrandTest::Record, &order, i);
+			}
+			strand.Wait();
+			threadpool.Wait();
+
+			Assert::AreEqual((std::size_t)REPETITION_NUMBER, order.size());
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				Assert::AreEqual(i, order[i]);
+			}
+			Logger::WriteMessage("Strand->Order: End\n");
+		}
+
+		TEST_METHOD(Strand_Serial) {
+			Logger::WriteMessage("Strand->Serial: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			const long NUMBER_STRANDS = 16;
+			const long REPETITION_NUMBER = 2000;
+			std::vector<std::unique_ptr<Threading::Strand<Threading::ThreadPoolCPP>>> strands;
+			std::vector<StrandTest::Monitor> monitors(NUMBER_STRANDS);
+			for (long i = 0; i < NUMBER_STRANDS; ++i) {
+				strands.emplace_back(new Threading::Strand<Threading::ThreadPoolCPP>(threadpool));
+			}
+
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				for (long s = 0; s < NUMBER_STRANDS; ++s) {
+					strands[s]->Push(StrandTest::Enter, &monitors[s]);
+				}
+			}
+			for (auto& strand : strands) {
+				strand->Wait();
+			}
+			threadpool.Wait();
+
+			for (StrandTest::Monitor& monitor : monitors) {
+				Assert::AreEqual(REPETITION_NUMBER, monitor.executed.load());
+				Assert::AreEqual(1L, monitor.maxConcurrent.load());
+			}
+			Logger::WriteMessage("Strand->Serial: End\n");
+		}
+	};
+}
\ No newline at end of file
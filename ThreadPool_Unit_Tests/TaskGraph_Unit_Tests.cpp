@@ -0,0 +1,132 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "ThreadPoolCPP.hpp"
+#include "TaskGraph.hpp"
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(TaskGraphUnitTests) {
+	public:
+		TEST_METHOD(TaskGraph_Order) {
+			Logger::WriteMessage("TaskGraph->Order: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			const std::size_t LAYERS = 20;
+			const std::size_t WIDTH = 10;
+			const long REPETITION_NUMBER = 100;
+			// Every node checks that both of its predecessors already finished the current run
+			std::unique_ptr<std::atomic<long>[]> finished(new std::atomic<long>[LAYERS * WIDTH]);
+			std::atomic<long> run(0);
+			std::atomic<long> executed(0);
+			std::atomic<long> violations(0);
+			Threading::TaskGraph graph;
+			for (std::size_t layer = 0; layer < LAYERS; ++layer) {
+				for (std::size_t i = 0; i < WIDTH; ++i) {
+					std::size_t node = layer * WIDTH + i;
+					finished[node].store(-1);
+					std::size_t first = layer ? node - WIDTH : node;
+					std::size_t second = layer ? first - i + (i + 1) % WIDTH : node;
+					graph.AddNode([&, layer, node, first, second]() {
+						if (layer != 0 && (finished[first].load() != run.load() || finished[second].load() != run.load())) {
+							violations.fetch_add(1);
+						}
+						executed.fetch_add(1);
+						finished[node].store(run.load());
+					});
+					if (layer != 0) {
+						graph.AddEdge(first, node);
+						graph.AddEdge(second, node);
+					}
+				}
+			}
+			Assert::AreEqual(LAYERS * WIDTH, graph.Nodes());
+			Assert::AreEqual((LAYERS - 1) * WIDTH * 2, graph.Edges());
+
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				run.store(i);
+				graph.Run(threadpool);
+				Assert::AreEqual((long)(LAYERS * WIDTH) * (i + 1), executed.load());
+			}
+			Assert::AreEqual(0L, violations.load());
+			Logger::WriteMessage("TaskGraph->Order: Reruns Passed\n");
+
+			// The graph does not wait for unrelated work on the threadpool
+			Threading::TaskGraph empty;
+			empty.Run(threadpool);
+			Logger::WriteMessage("TaskGraph->Order: End\n");
+		}
+
+		TEST_METHOD(TaskGraph_Errors) {
+			Logger::WriteMessage("TaskGraph->Errors: Start\n");
+			Threading::ThreadPoolCPP threadpool(4);
+			Threading::TaskGraph graph;
+			std::atomic<long> executed(0);
+			bool fail = true;
+			Threading::NodeId first = graph.AddNode([&]() {
+				executed.fetch_add(1);
+				if (fail) {
+					throw std::runtime_error("failed");
+				}
+			});
+			Threading::NodeId second = graph.AddNode([&]() { executed.fetch_add(1); });
+			graph.AddEdge(first, second);
+			Assert::ExpectException<std::out_of_range>([&graph, first]() { graph.AddEdge(first, 2); });
+
+			// The node after the failing one is skipped, Wait rethrows and the next run starts afresh
+			Assert::ExpectException<std::runtime_error>([&graph, &threadpool]() { graph.Run(threadpool); });
+			Assert::AreEqual(1L, executed.load());
+			fail = false;
+			graph.Run(threadpool);
+			Assert::AreEqual(3L, executed.load());
+			Logger::WriteMessage("TaskGraph->Errors: Exceptions Passed\n");
+
+			graph.AddEdge(second, first);
+			Assert::ExpectException<std::invalid_argument>([&graph, &threadpool]() { graph.Run(threadpool); });
+			Logger::WriteMessage("TaskGraph->Errors: End\n");
+		}
+
+		TEST_METHOD(TaskGraph_AnyBackend) {
+			Logger::WriteMessage("TaskGraph->AnyBackend: Start\n");
+			SchedulerTest::InlinePool pool;
+			Threading::TaskGraph graph;
+			std::vector<long> values(3, 0);
+			Threading::NodeId source = graph.AddNode([&values]() { values[0] = 1; });
+			Threading::NodeId left = graph.AddNode([&values]() { values[1] = values[0] + 1; });
+			Threading::NodeId right = graph.AddNode([&values]() { values[2] = values[0] + 2; });
+			graph.AddEdge(source, left);
+			graph.AddEdge(source, right);
+			graph.Start(pool);
+			graph.Wait();
+			Assert::AreEqual(2L, values[1]);
+			Assert::AreEqual(3L, values[2]);
+			// The source's worker keeps one successor, only the source and the other successor are pushed
+			Assert::AreEqual((std::size_t)2, pool.pushed);
+			Logger::WriteMessage("TaskGraph->AnyBackend: Inline Passed\n");
+
+			// A refused push fails the run instead of leaving Wait blocked, the nodes behind it are skipped
+			std::atomic<long> executed(0);
+			Threading::TaskGraph fanout;
+			Threading::NodeId root = fanout.AddNode([&executed]() { executed.fetch_add(1); });
+			for (long i = 0; i < 4; ++i) {
+				fanout.AddEdge(root, fanout.AddNode([&executed]() { executed.fetch_add(1); }));
+			}
+			SchedulerTest::DeferredPool deferred(2);
+			fanout.Start(deferred);
+			// The root runs, one successor got the last push and the two refused ones fail the run, so no successor runs
+			deferred.Step();
+			deferred.Step();
+			Assert::ExpectException<std::runtime_error>([&fanout]() { fanout.Wait(); });
+			Assert::AreEqual(1L, executed.load());
+
+			// The same when a source cannot be pushed
+			SchedulerTest::DeferredPool full(0);
+			Assert::ExpectException<std::runtime_error>([&fanout, &full]() { fanout.Run(full); });
+			Assert::AreEqual(1L, executed.load());
+			Logger::WriteMessage("TaskGraph->AnyBackend: End\n");
+		}
+	};
+}
\ No newline at end of file
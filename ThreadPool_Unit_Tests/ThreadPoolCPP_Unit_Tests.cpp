@@ -1,7 +1,10 @@
 #include "UnitTestImplementations.hpp"
 #include "CppUnitTest.h"
 #include "ThreadPoolCPP.hpp"
+#include <chrono>
+#include <cstdio>
 #include <random>
+#include <thread>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -298,6 +301,370 @@ namespace ThreadPoolUnitTests {
 
 			Logger::WriteMessage("ThreadPoolCPP->Execution_Multiple: End\n");
 		}
+
+		TEST_METHOD(ThreadPoolCPP_Tracing) {
+			Logger::WriteMessage("ThreadPoolCPP->Tracing: Start\n");
+			Threading::ThreadPoolCPP threadpool(8);
+			long testValue = 0;
+			const long REPETITION_NUMBER = 100;
+
+			threadpool.Push(ExecutionTest::Function, std::ref(testValue));
+			threadpool.Wait();
+			ASSERT_EXPECTED_VALUE(true, threadpool.TraceEvents().empty());
+			Logger::WriteMessage("ThreadPoolCPP->Tracing: Disabled Passed\n");
+
+			threadpool.EnableTracing();
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.PushLabelled("Increment", ExecutionTest::Function, std::ref(testValue));
+			}
+			threadpool.Wait();
+			threadpool.DisableTracing();
+
+			std::vector<Threading::Trace::Event> events = threadpool.TraceEvents();
+			ASSERT_EXPECTED_VALUE((std::size_t)REPETITION_NUMBER, events.size());
+			for (const Threading::Trace::Event& event : events) {
+				ASSERT_EXPECTED_VALUE(std::string("Increment"), std::string(event.label));
+				Assert::IsTrue(event.enqueueTime != 0 && event.enqueueTime <= event.startTime && event.startTime <= event.endTime);
+				Assert::IsTrue(event.worker < 8);
+			}
+			Logger::WriteMessage("ThreadPoolCPP->Tracing: Events Passed\n");
+
+			Assert::IsTrue(threadpool.DumpTrace("ThreadPoolCPP_Tracing.json"));
+			std::remove("ThreadPoolCPP_Tracing.json");
+			Logger::WriteMessage("ThreadPoolCPP->Tracing: End\n");
+		}
+
+		TEST_METHOD(ThreadPoolCPP_Profiling) {
+			Logger::WriteMessage("ThreadPoolCPP->Profiling: Start\n");
+			Threading::ThreadPoolCPP threadpool(2);
+			const long REPETITION_NUMBER = 4;
+			auto spin = []() {
+				std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+				while (std::chrono::steady_clock::now() < end) {
+
+				}
+			};
+			auto sleep = []() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); };
+
+			threadpool.Push(sleep);
+			threadpool.Wait();
+			ASSERT_EXPECTED_VALUE(true, threadpool.ProfileResults().labels.empty());
+			Logger::WriteMessage("ThreadPoolCPP->Profiling: Disabled Passed\n");
+
+			threadpool.EnableProfiling();
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.PushLabelled("Spin", spin);
+				threadpool.PushLabelled("Sleep", sleep);
+			}
+			threadpool.Push(sleep);
+			threadpool.Wait();
+			threadpool.DisableProfiling();
+
+			Threading::Profile::Report report = threadpool.ProfileResults();
+			ASSERT_EXPECTED_VALUE((std::size_t)3, report.labels.size());
+			// Spinning burns its wall time on a processor, sleeping hardly any
+			ASSERT_EXPECTED_VALUE(std::string("Spin"), report.labels[0].label);
+			for (const Threading::Profile::LabelStats& stats : report.labels) {
+				ASSERT_EXPECTED_VALUE(stats.label == "Task" ? (std::uint64_t)1 : (std::uint64_t)REPETITION_NUMBER, stats.tasks);
+				Assert::IsTrue(stats.cpuNanoseconds <= stats.wallNanoseconds + 1000000);
+				if (stats.label != "Spin") {
+					Assert::IsTrue(stats.cpuNanoseconds * 2 < stats.wallNanoseconds);
+				}
+			}
+			Logger::WriteMessage("ThreadPoolCPP->Profiling: Times Passed\n");
+
+			// Counters are optional, workers refused perf events report why and count no task
+			Assert::IsTrue(report.countedWorkers + report.uncountedWorkers >= 1);
+			for (const Threading::Profile::LabelStats& stats : report.labels) {
+				if (report.countedWorkers == 0) {
+					ASSERT_EXPECTED_VALUE((std::uint64_t)0, stats.countedTasks);
+				} else if (stats.label == "Spin" && stats.countedTasks != 0) {
+					Assert::IsTrue(stats.instructions != 0 && stats.cycles != 0);
+				}
+			}
+			Assert::IsTrue(report.uncountedWorkers == 0 || report.counterError != 0);
+			Logger::WriteMessage("ThreadPoolCPP->Profiling: Counters Passed\n");
+
+			threadpool.ResetProfile();
+			ASSERT_EXPECTED_VALUE(true, threadpool.ProfileResults().labels.empty());
+			Logger::WriteMessage("ThreadPoolCPP->Profiling: End\n");
+		}
+
+		TEST_METHOD(ThreadPoolCPP_BlockingScope) {
+			Logger::WriteMessage("ThreadPoolCPP->BlockingScope: Start\n");
+			Threading::ThreadPoolCPPSettings settings;
+			settings.maxSpareThreads = 2;
+			Threading::ThreadPoolCPP threadpool(2, settings);
+			std::atomic<bool> release(false);
+			std::atomic<long> released(0);
+			ASSERT_EXPECTED_VALUE((std::size_t)2, threadpool.StartedThreads());
+
+			{
+				// Outside a worker the scope is a no-op
+				Threading::BlockingScope scope;
+				ASSERT_EXPECTED_VALUE((std::size_t)0, threadpool.BlockedThreads());
+			}
+
+			// Both workers block, only a spare worker can run the release
+			threadpool.Push(BlockingTest::Block, &release, &released);
+			threadpool.Push(BlockingTest::Block, &release, &released);
+			threadpool.Push(BlockingTest::Release, &release);
+			threadpool.Wait();
+
+			ASSERT_EXPECTED_VALUE(2L, released.load());
+			ASSERT_EXPECTED_VALUE((std::size_t)0, threadpool.BlockedThreads());
+			Assert::IsTrue(threadpool.StartedThreads() > 2 && threadpool.StartedThreads() <= 4);
+			Logger::WriteMessage("ThreadPoolCPP->BlockingScope: End\n");
+		}
+
+		TEST_METHOD(ThreadPoolCPP_BlockingScopeWait) {
+			Logger::WriteMessage("ThreadPoolCPP->BlockingScopeWait: Start\n");
+			const long REPETITION_NUMBER = 100;
+			Threading::ThreadPoolCPPSettings settings;
+			settings.maxSpareThreads = 2;
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				// A new threadpool each time, Wait runs while the spare workers are being started rather than woken
+				Threading::ThreadPoolCPP threadpool(2, settings);
+				std::atomic<bool> release(false);
+				std::atomic<long> released(0);
+				threadpool.Push(BlockingTest::Block, &release, &released);
+				threadpool.Push(BlockingTest::Block, &release, &released);
+				threadpool.Push(BlockingTest::Release, &release);
+				threadpool.Wait();
+				ASSERT_EXPECTED_VALUE(2L, released.load());
+			}
+			Logger::WriteMessage("ThreadPoolCPP->BlockingScopeWait: End\n");
+		}
+
+		TEST_METHOD(ThreadPoolCPP_Shutdown) {
+			Logger::WriteMessage("ThreadPoolCPP->Shutdown: Start\n");
+			const long REPETITION_NUMBER = 100;
+			{
+				Threading::ThreadPoolCPP threadpool(2);
+				std::atomic<long> executed(0);
+				threadpool.Pause();
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.Push(ShutdownTest::Count, &executed);
+				}
+				// Drain resumes a paused threadpool and runs everything queued
+				Threading::ShutdownReport report = threadpool.Shutdown(Threading::ShutdownMode::Drain);
+				ASSERT_EXPECTED_VALUE(REPETITION_NUMBER, executed.load());
+				ASSERT_EXPECTED_VALUE((std::size_t)0, report.dropped);
+				ASSERT_EXPECTED_VALUE(false, report.timedOut);
+			}
+			Logger::WriteMessage("ThreadPoolCPP->Shutdown: Drain Passed\n");
+
+			{
+				Threading::ThreadPoolCPP threadpool(1);
+				std::atomic<bool> started(false);
+				std::atomic<bool> release(false);
+				std::atomic<long> executed(0);
+				threadpool.Push(ShutdownTest::Hold, &started, &release);
+				while (!started.load()) {
+					std::this_thread::yield();
+				}
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.PushLabelled("Dropped", ShutdownTest::Count, &executed);
+				}
+				// Queued tasks are dropped at once, the running task is released later and waited for
+				std::thread releaser([&release]() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); release.store(true); });
+				Threading::ShutdownReport report = threadpool.Shutdown(Threading::ShutdownMode::DropQueued);
+				releaser.join();
+				ASSERT_EXPECTED_VALUE(0L, executed.load());
+				ASSERT_EXPECTED_VALUE((std::size_t)REPETITION_NUMBER, report.dropped);
+				ASSERT_EXPECTED_VALUE(report.dropped, report.droppedLabels.size());
+				ASSERT_EXPECTED_VALUE(std::string("Dropped"), std::string(report.droppedLabels.front()));
+				ASSERT_EXPECTED_VALUE((std::size_t)0, report.abandoned);
+			}
+			Logger::WriteMessage("ThreadPoolCPP->Shutdown: DropQueued Passed\n");
+
+			{
+				std::atomic<bool> started(false);
+				std::atomic<bool> release(false);
+				std::atomic<long> executed(0);
+				Threading::ThreadPoolCPP threadpool(1);
+				threadpool.Push(ShutdownTest::Hold, &started, &release);
+				while (!started.load()) {
+					std::this_thread::yield();
+				}
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.Push(ShutdownTest::Count, &executed);
+				}
+				Threading::ShutdownReport report = threadpool.Shutdown(Threading::ShutdownMode::Deadline, std::chrono::milliseconds(20));
+				ASSERT_EXPECTED_VALUE(true, report.timedOut);
+				ASSERT_EXPECTED_VALUE((std::size_t)1, report.abandoned);
+				ASSERT_EXPECTED_VALUE((std::size_t)REPETITION_NUMBER, report.dropped);
+				Assert::IsTrue(report.elapsed < std::chrono::seconds(5));
+				// Destruction waits for the abandoned task
+				release.store(true);
+			}
+			Logger::WriteMessage("ThreadPoolCPP->Shutdown: Deadline Passed\n");
+			Logger::WriteMessage("ThreadPoolCPP->Shutdown: End\n");
+		}
+
+		TEST_METHOD(ThreadPoolCPP_Trivial) {
+			Logger::WriteMessage("ThreadPoolCPP->Trivial: Start\n");
+			const long REPETITION_NUMBER = 200;
+			Threading::ThreadPoolCPPSettings settings;
+			settings.coalesceLimit = 64;
+			Threading::ThreadPoolCPP threadpool(2, settings);
+			std::atomic<long> executed(0);
+
+			// Paused workers are idle, so every task is batched, one queued task per 64
+			threadpool.Pause();
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.PushTrivial(ShutdownTest::Count, &executed);
+			}
+			ASSERT_EXPECTED_VALUE((std::size_t)4, threadpool.QueuedTasks());
+			ASSERT_EXPECTED_VALUE(0L, executed.load());
+			threadpool.Resume();
+			threadpool.Wait();
+			ASSERT_EXPECTED_VALUE(REPETITION_NUMBER, executed.load());
+			ASSERT_EXPECTED_VALUE((std::uint64_t)REPETITION_NUMBER, threadpool.CompletedTasks());
+			Logger::WriteMessage("ThreadPoolCPP->Trivial: Batched Passed\n");
+
+			// From a worker they run inline before PushTrivial returns
+			std::atomic<long> inlined(0);
+			threadpool.Push([&threadpool, &executed, &inlined, REPETITION_NUMBER]() {
+				long before = executed.load();
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.PushTrivial(ShutdownTest::Count, &executed);
+				}
+				inlined.store(executed.load() - before);
+			});
+			threadpool.Wait();
+			ASSERT_EXPECTED_VALUE(REPETITION_NUMBER, inlined.load());
+			ASSERT_EXPECTED_VALUE(REPETITION_NUMBER * 2, executed.load());
+			ASSERT_EXPECTED_VALUE((std::uint64_t)REPETITION_NUMBER * 2 + 1, threadpool.CompletedTasks());
+			Logger::WriteMessage("ThreadPoolCPP->Trivial: Inline Passed\n");
+
+			// A user task sharing the batch label is still an ordinary task
+			threadpool.PushLabelled(Threading::ThreadPoolCPP::CoalescedLabel, ShutdownTest::Count, &executed);
+			threadpool.Wait();
+			ASSERT_EXPECTED_VALUE((std::uint64_t)REPETITION_NUMBER * 2 + 2, threadpool.CompletedTasks());
+			Logger::WriteMessage("ThreadPoolCPP->Trivial: Label Passed\n");
+
+			// Dropped trivial tasks are reported one by one, not as batches
+			threadpool.Pause();
+			for (long i = 0; i < REPETITION_NUMBER; ++i) {
+				threadpool.PushTrivial(ShutdownTest::Count, &executed);
+			}
+			threadpool.PushLabelled(Threading::ThreadPoolCPP::CoalescedLabel, ShutdownTest::Count, &executed);
+			Threading::ShutdownReport report = threadpool.Shutdown(Threading::ShutdownMode::DropQueued);
+			ASSERT_EXPECTED_VALUE((std::size_t)REPETITION_NUMBER + 1, report.dropped);
+			ASSERT_EXPECTED_VALUE((std::size_t)1, report.droppedLabels.size());
+			Logger::WriteMessage("ThreadPoolCPP->Trivial: End\n");
+		}
+
+		TEST_METHOD(ThreadPoolCPP_LazyStart) {
+			Logger::WriteMessage("ThreadPoolCPP->LazyStart: Start\n");
+			const long REPETITION_NUMBER = 100;
+			{
+				Threading::ThreadPoolCPPSettings settings;
+				settings.lazyStart = true;
+				Threading::ThreadPoolCPP threadpool(4, settings);
+				std::atomic<long> executed(0);
+				ASSERT_EXPECTED_VALUE((std::size_t)0, threadpool.StartedThreads());
+				threadpool.Wait();
+
+				threadpool.Push(ShutdownTest::Count, &executed);
+				threadpool.Wait();
+				ASSERT_EXPECTED_VALUE(1L, executed.load());
+				Assert::IsTrue(threadpool.StartedThreads() >= 1);
+
+				// Two held workers leave the rest of the work to workers started on demand
+				std::atomic<bool> started(false);
+				std::atomic<bool> release(false);
+				threadpool.Push(ShutdownTest::Hold, &started, &release);
+				threadpool.Push(ShutdownTest::Hold, &started, &release);
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.Push(ShutdownTest::Count, &executed);
+				}
+				while (executed.load() != REPETITION_NUMBER + 1) {
+					std::this_thread::yield();
+				}
+				release.store(true);
+				threadpool.Wait();
+				Assert::IsTrue(threadpool.StartedThreads() >= 3 && threadpool.StartedThreads() <= 4);
+			}
+			Logger::WriteMessage("ThreadPoolCPP->LazyStart: Lazy Passed\n");
+
+			{
+				Threading::ThreadPoolCPPSettings settings;
+				settings.waitForWorkers = false;
+				Threading::ThreadPoolCPP threadpool(4, settings);
+				std::atomic<long> executed(0);
+				ASSERT_EXPECTED_VALUE((std::size_t)4, threadpool.StartedThreads());
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.Push(ShutdownTest::Count, &executed);
+				}
+				threadpool.Wait();
+				ASSERT_EXPECTED_VALUE(REPETITION_NUMBER, executed.load());
+			}
+			Logger::WriteMessage("ThreadPoolCPP->LazyStart: End\n");
+		}
+
+		TEST_METHOD(ThreadPoolCPP_DequeueBatch) {
+			Logger::WriteMessage("ThreadPoolCPP->DequeueBatch: Start\n");
+			const long REPETITION_NUMBER = 1000;
+			{
+				Threading::ThreadPoolCPP threadpool(1);
+				std::atomic<long> executed(0);
+				threadpool.Pause();
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.Push(ShutdownTest::Count, &executed);
+				}
+				threadpool.Resume();
+				threadpool.Wait();
+				ASSERT_EXPECTED_VALUE(REPETITION_NUMBER, executed.load());
+				// A lone worker takes full batches of 16
+				Assert::IsTrue(threadpool.DequeueLocks() <= REPETITION_NUMBER / 16 + 2);
+			}
+			Logger::WriteMessage("ThreadPoolCPP->DequeueBatch: Batches Passed\n");
+
+			{
+				// Tasks waiting in a held worker's batch still count as queued
+				Threading::ThreadPoolCPP threadpool(1);
+				std::atomic<bool> started(false);
+				std::atomic<bool> release(false);
+				std::atomic<long> executed(0);
+				threadpool.Pause();
+				threadpool.Push(ShutdownTest::Hold, &started, &release);
+				for (long i = 0; i < 15; ++i) {
+					threadpool.Push(ShutdownTest::Count, &executed);
+				}
+				threadpool.Resume();
+				while (!started.load()) {
+					std::this_thread::yield();
+				}
+				ASSERT_EXPECTED_VALUE((std::size_t)15, threadpool.QueuedTasks());
+				release.store(true);
+				threadpool.Wait();
+				ASSERT_EXPECTED_VALUE((std::size_t)0, threadpool.QueuedTasks());
+			}
+			Logger::WriteMessage("ThreadPoolCPP->DequeueBatch: Queued Passed\n");
+
+			{
+				// Tasks taken together with a long one are stolen by the other worker
+				Threading::ThreadPoolCPP threadpool(2);
+				std::atomic<bool> started(false);
+				std::atomic<bool> release(false);
+				std::atomic<long> executed(0);
+				threadpool.Pause();
+				threadpool.Push(ShutdownTest::Hold, &started, &release);
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.Push(ShutdownTest::Count, &executed);
+				}
+				threadpool.Resume();
+				while (executed.load() != REPETITION_NUMBER) {
+					std::this_thread::yield();
+				}
+				release.store(true);
+				threadpool.Wait();
+				ASSERT_EXPECTED_VALUE(true, started.load());
+			}
+			Logger::WriteMessage("ThreadPoolCPP->DequeueBatch: End\n");
+		}
 #undef ASSERT_EXPECTED_VALUE
 #undef ASSERT_EXPECTED_STORE
 	};
@@ -0,0 +1,62 @@
+#include "UnitTestImplementations.hpp"
+#include "CppUnitTest.h"
+#include "TypedThreadPool.hpp"
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ThreadPoolUnitTests {
+	TEST_CLASS(TypedThreadPoolUnitTests) {
+	public:
+		TEST_METHOD(TypedThreadPool_Constructor) {
+			{
+				Threading::TypedThreadPool<TypedTest::Accumulate, std::atomic<long>*, long> threadpool(8, TypedTest::Accumulate(), 100);
+				Assert::AreEqual((std::size_t)128, threadpool.Capacity());
+				Logger::WriteMessage("TypedThreadPool->Constructor Passed.\n");
+			}
+			Logger::WriteMessage("TypedThreadPool->Destructor Passed.\n");
+		}
+
+		TEST_METHOD(TypedThreadPool_Execution) {
+			Logger::WriteMessage("TypedThreadPool->Execution: Start\n");
+			std::atomic<long> testValue(0);
+			long expectedValue = 0;
+			const long REPETITION_NUMBER = 100000;
+			{
+				// Capacity far below the task count exercises the full-ring path
+				Threading::TypedThreadPool<TypedTest::Accumulate, std::atomic<long>*, long> threadpool(8, TypedTest::Accumulate(), 64);
+				for (long i = 0; i < REPETITION_NUMBER; ++i) {
+					threadpool.Push(&testValue, i);
+					expectedValue += i;
+				}
+				threadpool.Wait();
+				Assert::AreEqual(expectedValue, testValue.load());
+				Logger::WriteMessage("TypedThreadPool->Execution: Wait Passed\n");
+
+				threadpool.Pause();
+				threadpool.Push(&testValue, 1L);
+				threadpool.Wait();
+				Assert::AreEqual(expectedValue, testValue.load());
+				threadpool.Resume();
+				threadpool.Wait();
+				Assert::AreEqual(expectedValue + 1, testValue.load());
+				Logger::WriteMessage("TypedThreadPool->Execution: Pause Passed\n");
+			}
+			Logger::WriteMessage("TypedThreadPool->Execution: End\n");
+		}
+
+		TEST_METHOD(TypedThreadPool_MoveOnly) {
+			std::atomic<long> testValue(0);
+			{
+				auto consume = [&testValue](std::unique_ptr<long> value) { testValue += *value; };
+				Threading::TypedThreadPool<decltype(consume), std::unique_ptr<long>> threadpool(4, consume);
+				for (long i = 0; i < 1000; ++i) {
+					threadpool.Push(std::unique_ptr<long>(new long(2)));
+				}
+			}
+			// The destructor runs every queued task
+			Assert::AreEqual(2000L, testValue.load());
+			Logger::WriteMessage("TypedThreadPool->MoveOnly Passed.\n");
+		}
+	};
+}
\ No newline at end of file
@@ -1,4 +1,8 @@
 #include "UnitTestImplementations.hpp"
+#include <thread>
+#include <algorithm>
+#include "ThreadPoolCPP.hpp"
+#include "ForkJoin.hpp"
 
 #pragma region ConstructorTests
 	void ConstructorTest::Function() {
@@ -26,4 +30,111 @@
 	void ExecutionTest::OverloadFunction(long& x, long changeValue) {
 		_InterlockedExchangeAdd(&x, changeValue);
 	}
+#pragma endregion
+
+#pragma region StrandTests
+	void StrandTest::Record(std::vector<long>* order, long value) {
+		order->push_back(value);
+	}
+
+	void StrandTest::Enter(Monitor* monitor) {
+		long concurrent = ++monitor->concurrent;
+		long maxConcurrent = monitor->maxConcurrent.load();
+		while (concurrent > maxConcurrent && !monitor->maxConcurrent.compare_exchange_weak(maxConcurrent, concurrent)) {
+
+		}
+		std::this_thread::yield();
+		++monitor->executed;
+		--monitor->concurrent;
+	}
+#pragma endregion
+
+#pragma region HillClimbingTests
+	void HillClimbingTest::Spin(std::chrono::microseconds duration) {
+		auto end = std::chrono::steady_clock::now() + duration;
+		while (std::chrono::steady_clock::now() < end) {
+
+		}
+	}
+
+	void HillClimbingTest::Measure(StrandTest::Monitor* monitor, std::chrono::microseconds duration) {
+		long concurrent = ++monitor->concurrent;
+		long maxConcurrent = monitor->maxConcurrent.load();
+		while (concurrent > maxConcurrent && !monitor->maxConcurrent.compare_exchange_weak(maxConcurrent, concurrent)) {
+
+		}
+		std::this_thread::sleep_for(duration);
+		++monitor->executed;
+		--monitor->concurrent;
+	}
+#pragma endregion
+
+#pragma region BlockingTests
+	void BlockingTest::Block(std::atomic<bool>* release, std::atomic<long>* released) {
+		Threading::BlockingScope scope;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!release->load() && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if (release->load()) {
+			++*released;
+		}
+	}
+
+	void BlockingTest::Release(std::atomic<bool>* release) {
+		release->store(true);
+	}
+#pragma endregion
+
+#pragma region ForkJoinTests
+	long ForkJoinTest::Fibonacci(long n) {
+		if (n < 12) {
+			return n < 2 ? n : Fibonacci(n - 1) + Fibonacci(n - 2);
+		}
+		long left = 0;
+		Threading::ForkJoinTask child([&left, n]() { left = Fibonacci(n - 1); });
+		Threading::ForkJoin scope;
+		scope.Spawn(child);
+		long right = Fibonacci(n - 2);
+		scope.Sync();
+		return left + right;
+	}
+
+	void ForkJoinTest::QuickSort(long* first, long* last) {
+		if (last - first < 256) {
+			std::sort(first, last);
+			return;
+		}
+		long pivot = first[(last - first) / 2];
+		long* middle1 = std::partition(first, last, [pivot](long value) { return value < pivot; });
+		long* middle2 = std::partition(middle1, last, [pivot](long value) { return !(pivot < value); });
+		Threading::ForkJoin::Invoke([first, middle1]() { QuickSort(first, middle1); }, [middle2, last]() { QuickSort(middle2, last); });
+	}
+#pragma endregion
+
+#pragma region ShutdownTests
+	void ShutdownTest::Hold(std::atomic<bool>* started, std::atomic<bool>* release) {
+		started->store(true);
+		while (!release->load()) {
+			std::this_thread::yield();
+		}
+	}
+
+	void ShutdownTest::Count(std::atomic<long>* executed) {
+		++*executed;
+	}
+#pragma endregion
+
+#pragma region ArenaTests
+	void ArenaTest::Scratch(std::atomic<long>* total, long count) {
+		std::vector<long, Threading::ArenaAllocator<long>> values(Threading::ThreadPoolCPP::ScratchAllocator<long>());
+		for (long i = 1; i <= count; ++i) {
+			values.push_back(i);
+		}
+		long sum = 0;
+		for (long value : values) {
+			sum += value;
+		}
+		*total += sum;
+	}
 #pragma endregion
\ No newline at end of file
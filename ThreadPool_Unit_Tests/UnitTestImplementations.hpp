@@ -1,6 +1,11 @@
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <mutex>
+#include <stdexcept>
+#include <vector>
 
 // ConstructorTest functions have no body
 namespace ConstructorTest {
@@ -95,4 +100,163 @@ namespace ExecutionTest {
 			_InterlockedExchange(x, store);
 		}
 	};
+}
+
+namespace StrandTest {
+	struct Monitor {
+		std::atomic<long> concurrent{ 0 };
+		std::atomic<long> maxConcurrent{ 0 };
+		std::atomic<long> executed{ 0 };
+	};
+
+	void Record(std::vector<long>* order, long value);
+
+	void Enter(Monitor* monitor);
+}
+
+namespace HillClimbingTest {
+	// Busy work of roughly the given duration
+	void Spin(std::chrono::microseconds duration);
+
+	// Tracks the highest number of concurrent callers
+	void Measure(StrandTest::Monitor* monitor, std::chrono::microseconds duration);
+}
+
+namespace BlockingTest {
+	// Waits inside a BlockingScope until release is set or a deadline passes, counts successful releases
+	void Block(std::atomic<bool>* release, std::atomic<long>* released);
+
+	void Release(std::atomic<bool>* release);
+}
+
+namespace TypedTest {
+	struct Accumulate {
+		void operator()(std::atomic<long>* total, long value) const {
+			*total += value;
+		}
+	};
+}
+
+namespace SortTest {
+	// No default constructor, ParallelSort must sort it like std::sort does
+	struct Keyed {
+		long value;
+
+		explicit Keyed(long value) : value(value) {
+
+		}
+
+		bool operator<(const Keyed& other) const {
+			return value < other.value;
+		}
+
+		bool operator==(const Keyed& other) const {
+			return value == other.value;
+		}
+	};
+}
+
+namespace PipelineTest {
+	struct Token {
+		long value = 0;
+	};
+}
+
+namespace ForkJoinTest {
+	// Naive recursion down to a serial cutoff, spawns the left half and computes the right half inline
+	long Fibonacci(long n);
+
+	// Sorts [first, last) spawning the left partition
+	void QuickSort(long* first, long* last);
+}
+
+namespace EpochTest {
+	// Counts destructions and poisons itself so a read after free is detectable
+	struct Node {
+		static constexpr long Magic = 0x5EED;
+
+		long magic;
+		std::atomic<long>* destroyed;
+
+		Node(std::atomic<long>* d) : magic(Magic), destroyed(d) {
+
+		}
+
+		~Node() {
+			magic = 0;
+			++*destroyed;
+		}
+	};
+}
+
+namespace ShutdownTest {
+	// Signals started then spins until release is set
+	void Hold(std::atomic<bool>* started, std::atomic<bool>* release);
+
+	void Count(std::atomic<long>* executed);
+}
+
+namespace ArenaTest {
+	// Sums 1..count in a vector built from the worker's scratch allocator
+	void Scratch(std::atomic<long>* total, long count);
+}
+
+namespace SchedulerTest {
+	// Minimal backend without PushBatch, runs every task on the pushing thread
+	struct InlinePool {
+		std::size_t pushed = 0;
+
+		template <class _FuncTy, class..._ArgsTy>
+		void Push(_FuncTy functor, _ArgsTy...args) {
+			++pushed;
+			functor(args...);
+		}
+	};
+
+	// Keeps tasks until Run, the push after limit pushes throws
+	struct DeferredPool {
+		std::size_t limit;
+		std::size_t pushed;
+		std::vector<std::function<void()>> tasks;
+
+		explicit DeferredPool(std::size_t l) : limit(l), pushed(0) {
+
+		}
+
+		template <class _FuncTy, class..._ArgsTy>
+		void Push(_FuncTy functor, _ArgsTy...args) {
+			if (pushed == limit) {
+				throw std::runtime_error("DeferredPool full");
+			}
+			++pushed;
+			tasks.emplace_back([functor, args...]() { functor(args...); });
+		}
+
+		// Runs the tasks queued so far, tasks they push wait for the next step
+		void Step() {
+			std::vector<std::function<void()>> running;
+			running.swap(tasks);
+			for (std::function<void()>& task : running) {
+				task();
+			}
+		}
+	};
+
+	struct CountingReceiver {
+		std::size_t* values;
+		std::size_t* errors;
+
+		template <class..._ArgsTy>
+		void set_value(_ArgsTy&&...) {
+			++*values;
+		}
+
+		void set_error(std::exception_ptr) noexcept {
+			++*errors;
+		}
+
+		void set_stopped() noexcept {
+
+		}
+	};
 }
\ No newline at end of file